@@ -4,7 +4,14 @@
 #undef UNIT_TEST_BATCH
 #define UNIT_TEST_BATCH Keg_
 
+#include <fstream>
+#include <functional>
+
+#include <include/io/FileOps.h>
 #include <include/io/Keg.h>
+#include <include/io/KegParallel.h>
+#include <include/io/KegPlan.h>
+#include <include/Timing.h>
 
 const cString TestKeg1 = R"(
 x: 100
@@ -46,3 +53,431 @@ TEST(Parse) {
     delete[] data.other;
     return true;
 }
+
+enum class KTShape : ui8 {
+    CUBE,
+    CROSS,
+    FLAT
+};
+KEG_ENUM_DECL(KTShape);
+
+struct KTMaterial {
+public:
+    f32 hardness;
+    nString sound;
+};
+KEG_TYPE_DECL(KTMaterial);
+
+struct KTBlock {
+public:
+    nString name;
+    ui16 id;
+    f32v3 color;
+    bool solid;
+    KTShape shape;
+    KTMaterial material;
+    Array<i32> textures;
+};
+KEG_TYPE_DECL(KTBlock);
+
+struct KTLink {
+public:
+    i32 value;
+    KTLink* next;
+};
+KEG_TYPE_DECL(KTLink);
+
+KEG_ENUM_DEF(KTShape, KTShape, ke) {
+    ke.addValue("Cube", KTShape::CUBE);
+    ke.addValue("Cross", KTShape::CROSS);
+    ke.addValue("Flat", KTShape::FLAT);
+}
+KEG_TYPE_DEF(KTMaterial, KTMaterial, kt) {
+    using namespace keg;
+
+    kt.addValue("hardness", Value::basic(offsetof(KTMaterial, hardness), BasicType::F32));
+    kt.addValue("sound", Value::basic(offsetof(KTMaterial, sound), BasicType::STRING));
+}
+KEG_TYPE_DEF(KTBlock, KTBlock, kt) {
+    using namespace keg;
+
+    kt.addValue("name", Value::basic(offsetof(KTBlock, name), BasicType::STRING));
+    kt.addValue("id", Value::basic(offsetof(KTBlock, id), BasicType::UI16));
+    kt.addValue("color", Value::basic(offsetof(KTBlock, color), BasicType::F32_V3));
+    kt.addValue("solid", Value::basic(offsetof(KTBlock, solid), BasicType::BOOL));
+    kt.addValue("shape", Value::custom(offsetof(KTBlock, shape), "KTShape", true));
+    kt.addValue("material", Value::custom(offsetof(KTBlock, material), "KTMaterial"));
+    kt.addValue("textures", Value::array(offsetof(KTBlock, textures), BasicType::I32));
+}
+KEG_TYPE_DEF(KTLink, KTLink, kt) {
+    using namespace keg;
+
+    kt.addValue("value", Value::basic(offsetof(KTLink, value), BasicType::I32));
+    kt.addValue("next", Value::ptr(offsetof(KTLink, next), Value::custom(0, "KTLink")));
+}
+
+namespace {
+    /// Block definitions like a game's data files
+    nString makeBlockYAML(size_t i) {
+        const char* SHAPES[3] = { "Cube", "Cross", "Flat" };
+        char buffer[512];
+        snprintf(buffer, sizeof(buffer),
+                 "name: \"block_%u\"\nid: %u\ncolor: [%.2f, %.2f, %.2f]\nsolid: %s\nshape: %s\n"
+                 "material:\n  hardness: %.1f\n  sound: \"sound_%u\"\ntextures: [%u, %u, %u, %u, %u, %u]\n",
+                 (ui32)i, (ui32)i, (i % 7) / 7.0f, (i % 11) / 11.0f, (i % 13) / 13.0f, (i % 5) ? "true" : "false", SHAPES[i % 3],
+                 (i % 9) * 0.5f, (ui32)(i % 17), (ui32)i, (ui32)i + 1, (ui32)i + 2, (ui32)i + 3, (ui32)i + 4, (ui32)i + 5);
+        return buffer;
+    }
+
+    bool sameBlock(const KTBlock& a, const KTBlock& b) {
+        if (a.name != b.name || a.id != b.id || a.color != b.color || a.solid != b.solid || a.shape != b.shape) return false;
+        if (a.material.hardness != b.material.hardness || a.material.sound != b.material.sound) return false;
+        if (a.textures.size() != b.textures.size()) return false;
+        for (size_t i = 0; i < a.textures.size(); i++) {
+            if (a.textures[i] != b.textures[i]) return false;
+        }
+        return true;
+    }
+}
+
+TEST(Binary) {
+    // Round trip of basic values, strings and vectors
+    KT1 data;
+    keg::parse(&data, TestKeg1, "KT1");
+    std::vector<ui8> bytes;
+    if (!keg::writeBinary(bytes, &data, "KT1")) return false;
+    KT1 copy = {};
+    if (keg::readBinary(&copy, bytes.data(), bytes.size(), "KT1") != keg::Error::NONE) return false;
+    if (copy.x != 100 || copy.y != "Hello World" || strcmp(copy.other, "Cool") != 0 || copy.z != 0xf0) return false;
+    if (copy.fv != f32v4(1.0f, 3.0f, 10.0f, -1.0f)) return false;
+    delete[] data.other;
+    delete[] copy.other;
+
+    // Truncated data and stale schemas are rejected
+    KT1 other = {};
+    if (keg::readBinary(&other, bytes.data(), bytes.size() - 1, "KT1") != keg::Error::EARLY_EOF) return false;
+    keg::Type changed;
+    changed.setStructType<KT1>();
+    changed.addSuper(&KEG_GET_TYPE(KT1));
+    changed.addValue("w", keg::Value::basic(offsetof(KT1, x), keg::BasicType::I32));
+    if (keg::getSchemaHash(&changed) == keg::getSchemaHash(&KEG_GET_TYPE(KT1))) return false;
+    if (keg::readBinary(&other, bytes.data(), bytes.size(), &changed) != keg::Error::SCHEMA_MISMATCH) return false;
+
+    // Pointers to the same type
+    KTLink third = { 3, nullptr }, second = { 2, &third }, first = { 1, &second };
+    bytes.clear();
+    if (!keg::writeBinary(bytes, &first, "KTLink")) return false;
+    KTLink link = {};
+    if (keg::readBinary(&link, bytes.data(), bytes.size(), "KTLink") != keg::Error::NONE) return false;
+    if (link.value != 1 || !link.next || link.next->value != 2 || !link.next->next || link.next->next->value != 3 || link.next->next->next) return false;
+    delete link.next->next;
+    delete link.next;
+    return true;
+}
+
+TEST(BinaryBenchmark) {
+    const size_t COUNT = 3000;
+    std::vector<nString> documents(COUNT);
+    size_t yamlSize = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        documents[i] = makeBlockYAML(i);
+        yamlSize += documents[i].size();
+    }
+
+    std::vector<KTBlock> fromYAML(COUNT);
+    PreciseTimer timer;
+    for (size_t i = 0; i < COUNT; i++) {
+        if (keg::parse(&fromYAML[i], documents[i].c_str(), "KTBlock") != keg::Error::NONE) return false;
+    }
+    f64 yamlTime = timer.stop();
+
+    std::vector<std::vector<ui8>> caches(COUNT);
+    size_t binarySize = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        if (!keg::writeBinary(caches[i], &fromYAML[i], "KTBlock")) return false;
+        binarySize += caches[i].size();
+    }
+
+    std::vector<KTBlock> fromBinary(COUNT);
+    keg::Type* type = &KEG_GET_TYPE(KTBlock);
+    timer.start();
+    for (size_t i = 0; i < COUNT; i++) {
+        if (keg::readBinary(&fromBinary[i], caches[i].data(), caches[i].size(), type) != keg::Error::NONE) return false;
+    }
+    f64 binaryTime = timer.stop();
+
+    printf("%u blocks: YAML %u bytes in %lf ms, binary %u bytes in %lf ms\n",
+           (ui32)COUNT, (ui32)yamlSize, yamlTime, (ui32)binarySize, binaryTime);
+    for (size_t i = 0; i < COUNT; i++) {
+        if (!sameBlock(fromYAML[i], fromBinary[i])) return false;
+    }
+    return fromYAML[7].shape == KTShape::CROSS && fromYAML[7].textures.size() == 6;
+}
+
+TEST(CompiledPlan) {
+    // Basic values
+    keg::TypePlan plan;
+    plan.compile(&KEG_GET_TYPE(KT1));
+    KT1 expected, data;
+    keg::parse(&expected, TestKeg1, "KT1");
+    if (plan.parse(&data, TestKeg1) != keg::Error::NONE) return false;
+    if (data.x != expected.x || data.y != expected.y || strcmp(data.other, expected.other) != 0) return false;
+    if (data.z != expected.z || data.fv != expected.fv) return false;
+    delete[] expected.other;
+    delete[] data.other;
+
+    // Nested types, enums and arrays, with unknown keys skipped
+    keg::TypePlan blockPlan;
+    blockPlan.compile(&KEG_GET_TYPE(KTBlock));
+    if (blockPlan.getLayoutCount() != 2) return false;
+    for (size_t i = 0; i < 50; i++) {
+        nString document = makeBlockYAML(i) + "unknown:\n  a: 1\n  b: [1, 2]\n";
+        KTBlock a, b;
+        if (keg::parse(&a, document.c_str(), "KTBlock") != keg::Error::NONE) return false;
+        if (blockPlan.parse(&b, document.c_str()) != keg::Error::NONE) return false;
+        if (!sameBlock(a, b)) return false;
+    }
+
+    // Pointers to the same type share one layout
+    keg::TypePlan linkPlan;
+    linkPlan.compile(&KEG_GET_TYPE(KTLink));
+    if (linkPlan.getLayoutCount() != 1) return false;
+    KTLink link = {};
+    if (linkPlan.parse(&link, "value: 1\nnext:\n  value: 2\n  next:\n    value: 3\n") != keg::Error::NONE) return false;
+    if (link.value != 1 || !link.next || link.next->value != 2 || !link.next->next || link.next->next->value != 3 || link.next->next->next) return false;
+    delete link.next->next;
+    delete link.next;
+
+    KT1 bad;
+    return plan.parse(&bad, "[1, 2]") == keg::Error::BAD_VALUE;
+}
+
+TEST(ReaderDoubleFree) {
+    keg::YAMLReader reader;
+    reader.init("a: 1\nb: 2\n");
+
+    // Freeing a node through two of its copies recycles it once
+    keg::Node a = reader.getInterior(reader.getFirst(), "a");
+    keg::Node copy = a;
+    reader.free(a);
+    reader.free(copy);
+    if (a != nullptr || copy != nullptr) return false;
+
+    // So the next two nodes are distinct
+    keg::Node b = reader.getInterior(reader.getFirst(), "b");
+    keg::Node c = reader.getInterior(reader.getFirst(), "a");
+    bool distinct = b != c;
+    reader.dispose();
+    return distinct;
+}
+
+TEST(ReaderNodeBenchmark) {
+    // About 10 MB of records, like a large generated data file
+    const size_t TARGET_SIZE = 10 << 20;
+    nString document;
+    document.reserve(TARGET_SIZE + 256);
+    char buffer[256];
+    for (size_t i = 0; document.size() < TARGET_SIZE; i++) {
+        snprintf(buffer, sizeof(buffer), "- name: item_%u\n  values: [%u, %u, %u, %u]\n  child:\n    a: %u\n    b: text_%u\n",
+                 (ui32)i, (ui32)i, (ui32)i + 1, (ui32)i + 2, (ui32)i + 3, (ui32)(i % 97), (ui32)i);
+        document += buffer;
+    }
+
+    PreciseTimer timer;
+    keg::YAMLReader reader;
+    reader.init(document.c_str());
+    f64 loadTime = timer.stop();
+
+    // Visit every node through the reader, freeing sequence elements as the Keg reader does
+    size_t nodes = 0;
+    std::function<void(keg::Node)> visit;
+    auto inMap = makeFunctor([&] (Sender, const nString&, keg::Node node) {
+        visit(node);
+    });
+    auto inSequence = makeFunctor([&] (Sender, size_t, keg::Node node) {
+        visit(node);
+        reader.free(node);
+    });
+    visit = [&] (keg::Node node) {
+        nodes++;
+        switch (keg::getType(node)) {
+        case keg::NodeType::MAP:
+            reader.forAllInMap(node, &inMap);
+            break;
+        case keg::NodeType::SEQUENCE:
+            reader.forAllInSequence(node, &inSequence);
+            break;
+        default:
+            break;
+        }
+    };
+    timer.start();
+    visit(reader.getFirst());
+    keg::Node name = reader.getInterior(reader.getFirst(), "missing");
+    reader.free(name);
+    f64 visitTime = timer.stop();
+
+    timer.start();
+    reader.dispose();
+    f64 disposeTime = timer.stop();
+
+    printf("%u bytes: load %lf ms, %u nodes visited in %lf ms, dispose %lf ms\n",
+           (ui32)document.size(), loadTime, (ui32)nodes, visitTime, disposeTime);
+    return nodes > 1000000 && name == nullptr;
+}
+
+TEST(Stream) {
+    // Basic values
+    KT1 expected, data;
+    keg::parse(&expected, TestKeg1, "KT1");
+    if (keg::parseStream(&data, TestKeg1, "KT1") != keg::Error::NONE) return false;
+    if (data.x != expected.x || data.y != expected.y || strcmp(data.other, expected.other) != 0) return false;
+    if (data.z != expected.z || data.fv != expected.fv) return false;
+    delete[] expected.other;
+    delete[] data.other;
+
+    // Nested types, enums and arrays, with unknown subtrees skipped, with and without a plan
+    keg::TypePlan blockPlan;
+    blockPlan.compile(&KEG_GET_TYPE(KTBlock));
+    for (size_t i = 0; i < 50; i++) {
+        nString document = "unknown:\n  a: [1, {b: 2}]\n  c: {d: [3]}\n" + makeBlockYAML(i);
+        KTBlock a, b, c, d;
+        if (keg::parse(&a, document.c_str(), "KTBlock") != keg::Error::NONE) return false;
+        if (keg::parseStream(&b, document.c_str(), "KTBlock") != keg::Error::NONE) return false;
+        if (!sameBlock(a, b)) return false;
+        if (keg::parseStream(&d, document.c_str(), "KTBlock", nullptr, &blockPlan) != keg::Error::NONE) return false;
+        if (!sameBlock(a, d)) return false;
+
+        // Keys that are not scalars, which keg::parse cannot read
+        document += "[1, 2]: complex\n";
+        if (keg::parseStream(&c, document.c_str(), "KTBlock") != keg::Error::NONE) return false;
+        if (!sameBlock(a, c)) return false;
+    }
+
+    // Pointers, with a leading type field
+    KTLink link = {};
+    const cString LINKS = "value: 1\nnext:\n  __TYPE__: KTLink\n  value: 2\n  next: {}\n";
+    if (keg::parseStream(&link, LINKS, "KTLink") != keg::Error::NONE) return false;
+    if (link.value != 1 || !link.next || link.next->value != 2 || !link.next->next || link.next->next->value != 0) return false;
+    delete link.next->next;
+    delete link.next;
+    keg::TypePlan linkPlan;
+    linkPlan.compile(&KEG_GET_TYPE(KTLink));
+    link = {};
+    if (keg::parseStream(&link, LINKS, "KTLink", nullptr, &linkPlan) != keg::Error::NONE) return false;
+    if (link.value != 1 || !link.next || link.next->value != 2 || !link.next->next || link.next->next->value != 0) return false;
+    delete link.next->next;
+    delete link.next;
+
+    // Documents that are not maps or not YAML
+    KT1 bad;
+    if (keg::parseStream(&bad, "[1, 2]", "KT1") != keg::Error::BAD_VALUE) return false;
+    if (keg::parseStream(&bad, "", "KT1") != keg::Error::EARLY_EOF) return false;
+    return keg::parseStream(&bad, "x: [1, 2", "KT1") == keg::Error::BAD_VALUE;
+}
+
+TEST(StreamBenchmark) {
+    // A few wanted fields next to a large subtree the type does not know
+    nString document = "hardness: 2.5\nsound: \"stone\"\nindex:\n";
+    char buffer[128];
+    for (size_t i = 0; document.size() < (4 << 20); i++) {
+        snprintf(buffer, sizeof(buffer), "  - { file: \"region_%u.dat\", offset: %u, sizes: [%u, %u] }\n", (ui32)i, (ui32)i * 4096, (ui32)i, (ui32)i + 1);
+        document += buffer;
+    }
+
+    KTMaterial loaded = {}, streamed = {};
+    PreciseTimer timer;
+    if (keg::parse(&loaded, document.c_str(), "KTMaterial") != keg::Error::NONE) return false;
+    f64 loadTime = timer.stop();
+    timer.start();
+    if (keg::parseStream(&streamed, document.c_str(), "KTMaterial") != keg::Error::NONE) return false;
+    f64 streamTime = timer.stop();
+
+    printf("%u bytes: loaded in %lf ms, streamed in %lf ms\n", (ui32)document.size(), loadTime, streamTime);
+    return loaded.hardness == streamed.hardness && loaded.sound == streamed.sound && streamed.sound == "stone";
+}
+
+TEST(StreamPlanBenchmark) {
+    const size_t COUNT = 3000;
+    std::vector<nString> documents(COUNT);
+    for (size_t i = 0; i < COUNT; i++) documents[i] = makeBlockYAML(i);
+    keg::Type* type = &KEG_GET_TYPE(KTBlock);
+    keg::TypePlan plan;
+    plan.compile(type);
+
+    // Best of several passes, since both parses are dominated by the YAML parser
+    const size_t PASSES = 10;
+    std::vector<KTBlock> streamed(COUNT), planned(COUNT);
+    f64 streamTime = 1e30, planTime = 1e30;
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        PreciseTimer timer;
+        for (size_t i = 0; i < COUNT; i++) {
+            if (keg::parseStream(&streamed[i], documents[i].c_str(), type) != keg::Error::NONE) return false;
+        }
+        streamTime = std::min(streamTime, timer.stop());
+        timer.start();
+        for (size_t i = 0; i < COUNT; i++) {
+            if (keg::parseStream(&planned[i], documents[i].c_str(), type, nullptr, &plan) != keg::Error::NONE) return false;
+        }
+        planTime = std::min(planTime, timer.stop());
+    }
+
+    printf("%u blocks streamed: by name %lf ms, through a plan %lf ms\n", (ui32)COUNT, streamTime, planTime);
+    for (size_t i = 0; i < COUNT; i++) {
+        if (!sameBlock(streamed[i], planned[i])) return false;
+    }
+    return true;
+}
+
+struct KTWorkerData {
+    bool stop = false;
+};
+
+TEST(ParseMany) {
+    // A directory of definition files, one missing and one broken
+    const size_t COUNT = 1500;
+    if (!vio::buildDirectoryTree("data/KegParseMany")) return false;
+    vio::IOManager iom("data/KegParseMany");
+    std::vector<vio::Path> paths;
+    char buffer[64];
+    for (size_t i = 0; i < COUNT; i++) {
+        snprintf(buffer, sizeof(buffer), "block_%u.yml", (ui32)i);
+        std::ofstream(nString("data/KegParseMany/") + buffer) << makeBlockYAML(i);
+        paths.push_back(buffer);
+    }
+    paths.push_back("missing.yml");
+    std::ofstream("data/KegParseMany/broken.yml") << "name: [1, 2";
+    paths.push_back("broken.yml");
+
+    keg::Type* type = &KEG_GET_TYPE(KTBlock);
+    std::vector<KTBlock> serial(COUNT);
+    PreciseTimer timer;
+    for (size_t i = 0; i < COUNT; i++) {
+        nString text;
+        if (!iom.readFileToString(paths[i], text)) return false;
+        if (keg::parse(&serial[i], text.c_str(), type) != keg::Error::NONE) return false;
+    }
+    f64 serialTime = timer.stop();
+
+    vcore::ThreadPool<KTWorkerData> pool;
+    pool.init(4);
+    timer.start();
+    keg::ParsedFiles files = keg::parseMany(paths, type, pool, nullptr, &iom);
+    f64 parallelTime = timer.stop();
+    pool.destroy();
+    printf("%u files: serial %lf ms, 4 workers %lf ms\n", (ui32)COUNT, serialTime, parallelTime);
+
+    // Results come back in input order
+    if (files.data.size() != paths.size() || files.errors.size() != paths.size()) return false;
+    for (size_t i = 0; i < COUNT; i++) {
+        if (files.errors[i] != keg::Error::NONE || !sameBlock(serial[i], files.data.at<KTBlock>(i))) return false;
+    }
+    if (files.errors[COUNT] != keg::Error::FILE_NOT_FOUND || files.errors[COUNT + 1] != keg::Error::BAD_VALUE) return false;
+
+    // Snapshots resolve the same names but refuse new ones
+    keg::Environment* frozen = keg::getGlobalEnvironment()->snapshot();
+    bool valid = frozen->isFrozen() && frozen->getType("KTBlock") == type && frozen->getEnum("KTShape") != nullptr;
+    valid &= frozen->addType("KTFrozen", type) == KEG_BAD_TYPE_ID && frozen->getType("KTFrozen") == nullptr;
+    delete frozen;
+    return valid;
+}
@@ -4,10 +4,12 @@
 #undef UNIT_TEST_BATCH
 #define UNIT_TEST_BATCH Utils_
 
+#include <algorithm>
 #include <random>
 #include <thread>
 
 #include <include/Event.hpp>
+#include <include/IDGenerator.h>
 #include <include/Random.h>
 #include <include/RingBuffer.hpp>
 #include <include/Timing.h>
@@ -303,3 +305,52 @@ TEST(DelegateSpeed) {
 
     return true;
 }
+
+TEST(GenerationalIDGenerator) {
+    vcore::GenerationalIDGenerator<ui32, 24> gen;
+    typedef vcore::GenerationalIDGenerator<ui32, 24>::Handle Handle;
+
+    bool wasNew;
+    Handle a = gen.generate(&wasNew);
+    if (!wasNew || a.getIndex() != 1 || a.getGeneration() != 0) return false;
+    if (!gen.recycle(a) || gen.recycle(a) || gen.isValid(a)) return false;
+
+    Handle b = gen.generate(&wasNew);
+    if (wasNew || b.getIndex() != a.getIndex() || b.getGeneration() != 1) return false;
+    if (gen.isValid(a) || !gen.isValid(b) || gen.isValid(Handle())) return false;
+
+    // Generations wrap around within their bits
+    for (ui32 i = 0; i < 255; i++) {
+        gen.recycle(b);
+        b = gen.generate();
+    }
+    return b.getGeneration() == 0 && gen.isValid(b) && gen.getActiveCount() == 1;
+}
+
+TEST(ConcurrentIDGenerator) {
+    const size_t THREADS = 4;
+    const size_t PER_THREAD = 10000;
+    vcore::ConcurrentIDGenerator<ui32> gen;
+
+    std::vector<std::vector<ui32>> ids(THREADS);
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < THREADS; t++) {
+        threads.emplace_back([&, t] () {
+            for (size_t i = 0; i < PER_THREAD; i++) {
+                ui32 id = gen.generate();
+                // Give every other ID back to be picked up again
+                if (i & 1) gen.recycle(id);
+                else ids[t].push_back(id);
+            }
+            ui32 first = gen.reserveBlock(16);
+            for (ui32 i = 0; i < 16; i++) ids[t].push_back(first + i);
+        });
+    }
+    for (auto& t : threads) t.join();
+
+    std::vector<ui32> all;
+    for (auto& v : ids) all.insert(all.end(), v.begin(), v.end());
+    std::sort(all.begin(), all.end());
+    if (std::adjacent_find(all.begin(), all.end()) != all.end()) return false;
+    return all.front() != ID_GENERATOR_NULL_ID && all.size() == THREADS * (PER_THREAD / 2 + 16);
+}
@@ -5,7 +5,13 @@
 #define UNIT_TEST_BATCH Vorb_Core_ECS_
 
 #include <include/ecs/ECS.h>
+#include <include/ecs/CommandBuffer.h>
 #include <include/ecs/ComponentTable.hpp>
+#include <include/ecs/ComponentView.hpp>
+#include <include/ecs/MultiComponentTracker.hpp>
+#include <include/Timing.h>
+
+#include <random>
 
 TEST(Creation) {
     vecs::ECS ecs;
@@ -41,4 +47,464 @@ TEST(MakeComponent) {
     vorb_assert(table, "Missing C1 table.");
 
     return true;
-}
\ No newline at end of file
+}
+/// Randomly adds and removes components, checking every entity against a plain array
+bool checkStorage(vecs::ComponentStorage storage) {
+    vecs::ECS ecs;
+    vecs::ComponentTable<Component> ct(storage);
+    ecs.addComponentTable("C1", &ct);
+
+    const size_t ENTITIES = 10000;
+    std::vector<vecs::EntityID> entities(ENTITIES);
+    ecs.genEntities(ENTITIES, entities.data());
+    std::vector<int> expected(ENTITIES + 1, -1);
+
+    std::mt19937 rng(1);
+    for (size_t i = 0; i < 100000; i++) {
+        vecs::EntityID e = entities[rng() % ENTITIES];
+        if (expected[e] == -1) {
+            ecs.addComponent("C1", e);
+            ct.getFromEntity(e).x = (int)e;
+            expected[e] = (int)e;
+        } else {
+            ecs.deleteComponent("C1", e);
+            expected[e] = -1;
+        }
+    }
+
+    size_t count = 0;
+    for (auto e : entities) {
+        vecs::ComponentID cID = ct.getComponentID(e);
+        if ((cID == ID_GENERATOR_NULL_ID) != (expected[e] == -1)) return false;
+        if (cID == ID_GENERATOR_NULL_ID) continue;
+        if (ct.get(cID).x != expected[e] || ct.get(cID).x != (int)e) return false;
+        count++;
+    }
+    if (count != ct.getComponentCount()) return false;
+
+    // Packed storage leaves no holes to iterate over
+    if (storage == vecs::ComponentStorage::PACKED) {
+        if (ct.getComponentListSize() != count + 1) return false;
+        for (auto& c : ct) {
+            if (c.first == ID_GENERATOR_NULL_ID || c.second.x != (int)c.first) return false;
+        }
+    }
+    return true;
+}
+
+TEST(StableStorage) {
+    return checkStorage(vecs::ComponentStorage::STABLE);
+}
+
+TEST(PackedStorage) {
+    return checkStorage(vecs::ComponentStorage::PACKED);
+}
+
+TEST(EntityLookup) {
+    const size_t ENTITIES = 200000;
+    vecs::ECS ecs;
+    vecs::ComponentTable<Component> ct(vecs::ComponentStorage::PACKED);
+    ecs.addComponentTable("C1", &ct);
+    std::vector<vecs::EntityID> entities(ENTITIES);
+    ecs.genEntities(ENTITIES, entities.data());
+    for (auto e : entities) ecs.addComponent("C1", e);
+
+    PreciseTimer timer;
+    int sum = 0;
+    for (size_t i = 0; i < 10; i++) {
+        for (auto e : entities) sum += ct.getFromEntity(e).x;
+    }
+    printf("getFromEntity over %u entities: %lf ms\n", (ui32)ENTITIES, timer.stop() / 10.0);
+    return sum == (int)(ENTITIES * 10 * 10);
+}
+
+struct TPViewWorkerData {
+    bool stop = false;
+};
+
+struct Position { f32 x = 0.0f, y = 0.0f, z = 0.0f; };
+struct Velocity { f32 x = 1.0f, y = 2.0f, z = 3.0f; };
+struct Mass { f32 m = 2.0f; };
+
+TEST(ComponentView) {
+    vecs::ECS ecs;
+    vecs::ComponentTable<Position> positions(vecs::ComponentStorage::PACKED);
+    vecs::ComponentTable<Velocity> velocities;
+    vecs::ComponentTable<Mass> masses(vecs::ComponentStorage::PACKED);
+    ecs.addComponentTable("Position", &positions);
+    ecs.addComponentTable("Velocity", &velocities);
+    ecs.addComponentTable("Mass", &masses);
+
+    // Every entity has a subset of the components
+    std::vector<vecs::EntityID> entities(1000);
+    ecs.genEntities(entities.size(), entities.data());
+    size_t expected = 0;
+    for (auto e : entities) {
+        if (e % 2) ecs.addComponent("Position", e);
+        if (e % 3) ecs.addComponent("Velocity", e);
+        if (e % 5) ecs.addComponent("Mass", e);
+        if ((e % 2) && (e % 3) && (e % 5)) expected++;
+    }
+
+    auto view = vecs::makeView(positions, velocities, masses);
+    size_t count = 0;
+    view.each([&] (vecs::EntityID e, Position& p, Velocity& v, Mass& m) {
+        if ((e % 2) && (e % 3) && (e % 5)) count++;
+        p.x += v.x * m.m;
+    });
+    if (count != expected) return false;
+
+    count = 0;
+    for (auto row : view) {
+        if (std::get<1>(row).x != 2.0f) return false;
+        count++;
+    }
+    if (count != expected) return false;
+
+    vcore::ThreadPool<TPViewWorkerData> pool;
+    pool.init(3);
+    std::atomic<size_t> parallelCount(0);
+    view.parallelEach(pool, 16, [&] (vecs::EntityID, Position& p, Velocity& v, Mass&) {
+        p.x += v.x;
+        parallelCount++;
+    });
+    pool.destroy();
+    if (parallelCount != expected) return false;
+    for (auto& p : positions) {
+        bool inView = (p.first % 3) && (p.first % 5);
+        if (p.second.x != (inView ? 3.0f : 0.0f)) return false;
+    }
+    return true;
+}
+
+TEST(TrackerStorage) {
+    vecs::ComponentTable<Position> positions;
+    vecs::ComponentTable<Velocity> velocities(vecs::ComponentStorage::PACKED);
+
+    // Packed component IDs move on removal, so the tracker refuses them, also through its base
+    vecs::MultiComponentTracker<2> tracker;
+    vecs::MultipleComponentSet& set = tracker;
+    set.addRequirement(&positions);
+    try {
+        set.addRequirement(&velocities);
+    } catch (std::runtime_error&) {
+        return true;
+    }
+    return false;
+}
+
+TEST(ComponentViewBenchmark) {
+    const size_t ENTITIES = 1000000;
+    vecs::ECS ecs;
+    vecs::ComponentTable<Position> positions;
+    vecs::ComponentTable<Velocity> velocities;
+    vecs::ComponentTable<Mass> masses;
+    ecs.addComponentTable("Position", &positions);
+    ecs.addComponentTable("Velocity", &velocities);
+    ecs.addComponentTable("Mass", &masses);
+
+    vecs::MultiComponentTracker<3> tracker;
+    tracker.addRequirement(&positions);
+    tracker.addRequirement(&velocities);
+    tracker.addRequirement(&masses);
+
+    std::vector<vecs::EntityID> entities(ENTITIES);
+    ecs.genEntities(ENTITIES, entities.data());
+    for (auto e : entities) {
+        ecs.addComponent("Position", e);
+        ecs.addComponent("Velocity", e);
+        ecs.addComponent("Mass", e);
+    }
+
+    // Best of several passes, every pass must update each entity exactly once
+    const size_t PASSES = 5;
+    auto check = [&] () {
+        for (auto& p : positions) {
+            if (p.second.x != 2.0f) return false;
+            p.second.x = 0.0f;
+        }
+        return true;
+    };
+    PreciseTimer timer;
+    f64 trackerTime = 1e30, viewTime = 1e30, parallelTime = 1e30;
+
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        timer.start();
+        for (vecs::EntityID e : tracker) {
+            auto& c = tracker.getComponents(e);
+            Position& p = positions.get(c[0]);
+            Velocity& v = velocities.get(c[1]);
+            p.x += v.x * masses.get(c[2]).m;
+        }
+        trackerTime = std::min(trackerTime, timer.stop());
+        if (!check()) return false;
+    }
+
+    auto view = vecs::makeView(positions, velocities, masses);
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        timer.start();
+        view.each([] (vecs::EntityID, Position& p, Velocity& v, Mass& m) {
+            p.x += v.x * m.m;
+        });
+        viewTime = std::min(viewTime, timer.stop());
+        if (!check()) return false;
+    }
+
+    vcore::ThreadPool<TPViewWorkerData> pool;
+    pool.init(std::max(1u, std::thread::hardware_concurrency() - 1));
+    for (size_t pass = 0; pass < PASSES; pass++) {
+        timer.start();
+        view.parallelEach(pool, 1024, [] (vecs::EntityID, Position& p, Velocity& v, Mass& m) {
+            p.x += v.x * m.m;
+        });
+        parallelTime = std::min(parallelTime, timer.stop());
+        if (!check()) return false;
+    }
+    pool.destroy();
+
+    printf("%u entities with 3 components, best of %u passes\n", (ui32)ENTITIES, (ui32)PASSES);
+    printf("MultiComponentTracker: %lf ms\n", trackerTime);
+    printf("ComponentView:         %lf ms\n", viewTime);
+    printf("parallelEach:          %lf ms\n", parallelTime);
+    return true;
+}
+
+TEST(BatchedEntities) {
+    vecs::ECS ecs;
+    vecs::ComponentTable<Component> ct(vecs::ComponentStorage::PACKED);
+    vecs::TableID tID = ecs.addComponentTable("C1", &ct);
+
+    size_t addedEvents = 0, removedEvents = 0, removedCount = 0;
+    auto fAdded = makeFunctor([&] (Sender, const vecs::EntityID*, size_t) { addedEvents++; });
+    auto fRemoved = makeFunctor([&] (Sender, const vecs::EntityID*, size_t n) {
+        removedEvents++;
+        removedCount += n;
+    });
+    size_t componentEvents = 0, componentCount = 0;
+    auto fComponents = makeFunctor([&] (Sender, vecs::TableID table, const vecs::EntityID*, size_t n) {
+        if (table == tID) componentEvents++;
+        componentCount += n;
+    });
+    ecs.onEntitiesAdded += fAdded;
+    ecs.onEntitiesRemoved += fRemoved;
+    ecs.onComponentsAdded += fComponents;
+
+    const size_t ENTITIES = 50000;
+    std::vector<vecs::EntityID> entities(ENTITIES);
+    PreciseTimer timer;
+    ecs.addEntities(ENTITIES, entities.data());
+    std::vector<vecs::ComponentID> components(ENTITIES);
+    size_t added = ecs.addComponents(tID, entities.data(), ENTITIES, components.data());
+    f64 batchTime = timer.stop();
+    if (added != ENTITIES || addedEvents != 1 || ct.getComponentCount() != ENTITIES) return false;
+    if (componentEvents != 1 || componentCount != ENTITIES) return false;
+    if (ecs.addComponents(tID, entities.data(), 10) != 0 || componentEvents != 1) return false;
+
+    vecs::ECS single;
+    vecs::ComponentTable<Component> singleCT;
+    single.addComponentTable("C1", &singleCT);
+    timer.start();
+    for (size_t i = 0; i < ENTITIES; i++) single.addComponent("C1", single.addEntity());
+    printf("%u entities with a component, one by one: %lf ms, batched: %lf ms\n", (ui32)ENTITIES, timer.stop(), batchTime);
+
+    // Delete every other entity, plus some IDs that don't exist
+    std::vector<vecs::EntityID> doomed;
+    for (size_t i = 0; i < ENTITIES; i += 2) doomed.push_back(entities[i]);
+    doomed.push_back(ENTITIES + 100);
+    if (ecs.deleteEntities(doomed.data(), doomed.size()) != ENTITIES / 2) return false;
+    if (removedEvents != 1 || removedCount != ENTITIES / 2 || ct.getComponentCount() != ENTITIES / 2) return false;
+    for (size_t i = 0; i < ENTITIES; i++) {
+        bool alive = (i & 1) != 0;
+        if ((ct.getComponentID(entities[i]) != ID_GENERATOR_NULL_ID) != alive) return false;
+    }
+
+    // Recycled IDs come back without stale component bits
+    std::vector<vecs::EntityID> reborn(ENTITIES / 2);
+    ecs.addEntities(reborn.size(), reborn.data());
+    for (auto e : reborn) {
+        if (ecs.hasComponent(tID, e)) return false;
+    }
+    return ecs.getActiveEntityCount() == ENTITIES;
+}
+
+/// Runs jobs on several threads that only record into their own command buffer
+std::vector<std::pair<vecs::EntityID, int>> runCommandJobs(size_t threads) {
+    const size_t JOBS = 64;
+    vecs::ECS ecs;
+    vecs::ComponentTable<Component> ct(vecs::ComponentStorage::PACKED);
+    vecs::TableID tID = ecs.addComponentTable("C1", &ct);
+    std::vector<vecs::EntityID> existing(JOBS);
+    ecs.addEntities(JOBS, existing.data());
+    ecs.addComponents(tID, existing.data(), JOBS);
+
+    std::vector<vecs::CommandBuffer> buffers(threads);
+    std::atomic<size_t> nextJob(0);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < threads; t++) {
+        workers.emplace_back([&, t] () {
+            vecs::CommandBuffer& cb = buffers[t];
+            for (size_t j = nextJob++; j < JOBS; j = nextJob++) {
+                cb.setSortKey((ui32)j);
+                for (int i = 0; i < 10; i++) {
+                    vecs::EntityID e = cb.createEntity();
+                    Component c;
+                    c.x = (int)j * 100 + i;
+                    cb.addComponent(tID, e, c);
+                    if (i == 9) cb.destroyEntity(e);
+                }
+                if (j & 1) cb.removeComponent(tID, existing[j]);
+                if (j % 3 == 0) cb.destroyEntity(existing[j]);
+            }
+        });
+    }
+    for (auto& w : workers) w.join();
+
+    std::vector<vecs::CommandBuffer*> order;
+    for (auto& cb : buffers) order.push_back(&cb);
+    vecs::CommandBuffer::playback(ecs, order.data(), order.size());
+
+    std::vector<std::pair<vecs::EntityID, int>> result;
+    for (auto& c : ct) result.emplace_back(c.first, c.second.x);
+    return result;
+}
+
+TEST(CommandBuffer) {
+    auto reference = runCommandJobs(1);
+    // Each job leaves 9 new entities, existing ones keep their component unless removed or destroyed
+    size_t kept = 0;
+    for (size_t j = 0; j < 64; j++) {
+        if (!(j & 1) && (j % 3 != 0)) kept++;
+    }
+    if (reference.size() != 64 * 9 + kept) return false;
+    for (size_t i = 0; i < 20; i++) {
+        if (runCommandJobs(4) != reference) return false;
+    }
+    return true;
+}
+
+TEST(BitTable) {
+    vecs::BitTable table;
+    std::vector<std::vector<bool>> expected;
+    std::mt19937 rng(3);
+
+    // Grow both ways past word boundaries while bits are being set
+    for (size_t step = 0; step < 6; step++) {
+        table.addColumns(27);
+        table.addRows(150);
+        for (auto& row : expected) row.resize(table.getBitColumnCount(), false);
+        expected.resize(table.getRowCount(), std::vector<bool>(table.getBitColumnCount(), false));
+        for (size_t i = 0; i < 2000; i++) {
+            ui32 r = rng() % table.getRowCount();
+            ui32 c = rng() % table.getBitColumnCount();
+            table.toggleValue(r, c);
+            expected[r][c] = !expected[r][c];
+        }
+    }
+    table.setRowFalse(5);
+    expected[5].assign(expected[5].size(), false);
+
+    std::vector<ui64> mask(table.getRowWordCount(), 0x8421084210842108ull);
+    mask.back() &= (1ull << (table.getBitColumnCount() & 63)) - 1;
+    table.orRow(7, mask.data());
+    table.andRow(8, mask.data());
+    for (ui32 c = 0; c < table.getBitColumnCount(); c++) {
+        bool m = ((mask[c >> 6] >> (c & 63)) & 1) != 0;
+        expected[7][c] = expected[7][c] || m;
+        expected[8][c] = expected[8][c] && m;
+    }
+    if (!table.getRow(7).containsAll(mask.data()) || !table.getRow(5).containsNone(mask.data())) return false;
+
+    for (ui32 r = 0; r < table.getRowCount(); r++) {
+        ui32 count = 0;
+        ui32 next = table.findNextSet(r, 0);
+        for (ui32 c = 0; c < table.getBitColumnCount(); c++) {
+            if (table.valueOf(r, c) != expected[r][c]) return false;
+            if (expected[r][c]) {
+                if (next != c) return false;
+                next = table.findNextSet(r, c + 1);
+                count++;
+            }
+        }
+        if (next != table.getBitColumnCount() || table.popcount(r) != count) return false;
+    }
+
+    // Column queries against a brute force scan
+    const ui32 all[] = { 3, 64, 100 };
+    const ui32 none[] = { 7, 150 };
+    for (size_t allCount = 0; allCount <= 3; allCount++) {
+        std::vector<ui32> rows;
+        table.queryRows(all, allCount, none, 2, rows);
+        std::vector<ui32> brute;
+        for (ui32 r = 0; r < table.getRowCount(); r++) {
+            bool match = !expected[r][7] && !expected[r][150];
+            for (size_t i = 0; i < allCount; i++) match = match && expected[r][all[i]];
+            if (match) brute.push_back(r);
+        }
+        if (rows != brute) return false;
+    }
+    return true;
+}
+
+TEST(QueryEntities) {
+    vecs::ECS ecs;
+    vecs::ComponentTable<Position> positions;
+    vecs::ComponentTable<Velocity> velocities;
+    vecs::ComponentTable<Mass> masses;
+    vecs::TableID pID = ecs.addComponentTable("Position", &positions);
+    vecs::TableID vID = ecs.addComponentTable("Velocity", &velocities);
+    vecs::TableID mID = ecs.addComponentTable("Mass", &masses);
+
+    const size_t ENTITIES = 100000;
+    std::vector<vecs::EntityID> entities(ENTITIES);
+    ecs.addEntities(ENTITIES, entities.data());
+    for (auto e : entities) {
+        if (e % 2) ecs.addComponent("Position", e);
+        if (e % 3) ecs.addComponent("Velocity", e);
+        if (e % 5 == 0) ecs.addComponent("Mass", e);
+    }
+    // Deleted entities must not show up
+    ecs.deleteEntity(7);
+
+    std::vector<vecs::EntityID> found;
+    PreciseTimer timer;
+    ecs.queryEntities({ pID, vID }, { mID }, found);
+    printf("Signature query over %u entities: %lf ms\n", (ui32)ENTITIES, timer.stop());
+
+    std::vector<vecs::EntityID> brute;
+    for (auto e : entities) {
+        if (e != 7 && (e % 2) && (e % 3) && (e % 5 != 0)) brute.push_back(e);
+    }
+    if (found != brute) return false;
+
+    found.clear();
+    ecs.queryEntities({}, { pID, vID, mID }, found);
+    for (auto e : found) {
+        if (e == 7 || (e % 2) || (e % 3) || (e % 5 == 0)) return false;
+    }
+    return found.size() == ENTITIES / 6 - ENTITIES / 30;
+}
+
+TEST(EntityHandles) {
+    vecs::ECS ecs;
+    vecs::EntityID e1 = ecs.addEntity();
+    vecs::EntityHandle h1 = ecs.getHandle(e1);
+    if (h1.getIndex() != e1 || !ecs.isAlive(h1)) return false;
+
+    // A reused ID gets a new generation
+    ecs.deleteEntity(e1);
+    if (ecs.isAlive(h1)) return false;
+    vecs::EntityID e2 = ecs.addEntity();
+    if (e2 != e1) return false;
+    vecs::EntityHandle h2 = ecs.getHandle(e2);
+    if (h2 == h1 || !ecs.isAlive(h2) || ecs.isAlive(h1)) return false;
+
+    std::vector<vecs::EntityID> ids(64);
+    ecs.addEntities(ids.size(), ids.data());
+    std::vector<vecs::EntityHandle> handles;
+    for (auto id : ids) handles.push_back(ecs.getHandle(id));
+    ecs.deleteEntities(ids.data(), 32);
+    for (size_t i = 0; i < handles.size(); i++) {
+        if (ecs.isAlive(handles[i]) != (i >= 32)) return false;
+    }
+    return !ecs.isAlive(vecs::EntityHandle()) && ecs.getActiveEntityCount() == 33;
+}
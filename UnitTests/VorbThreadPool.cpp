@@ -0,0 +1,410 @@
+#include "stdafx.h"
+#include "macros.h"
+
+#undef UNIT_TEST_BATCH
+#define UNIT_TEST_BATCH Vorb_ThreadPool_
+
+#include <atomic>
+
+#include <include/ParallelFor.h>
+#include <include/TaskGraph.h>
+#include <include/ThreadPool.h>
+#include <include/Timing.h>
+
+struct TPWorkerData {
+    bool stop = false;
+};
+typedef vcore::ThreadPool<TPWorkerData> TPool;
+
+/// Small task that optionally spawns children on the same pool
+class TPSpawnTask : public vcore::IThreadPoolTask<TPWorkerData> {
+public:
+    virtual void execute(TPWorkerData* workerData VORB_UNUSED) override {
+        // A few microseconds of work
+        ui32 v = seed;
+        for (size_t i = 0; i < 200; i++) v = v * 1664525u + 1013904223u;
+        sink += v & 1;
+
+        for (size_t i = 0; i < children; i++) {
+            TPSpawnTask* child = &pool->tasks[firstChild + i];
+            pool->threadPool.addTask(child);
+        }
+        pool->executed++;
+    }
+
+    struct Owner {
+        TPool threadPool;
+        std::vector<TPSpawnTask> tasks;
+        std::atomic<size_t> executed;
+    };
+
+    Owner* pool = nullptr;
+    ui32 seed = 0;
+    size_t firstChild = 0;
+    size_t children = 0;
+    static std::atomic<ui32> sink;
+};
+std::atomic<ui32> TPSpawnTask::sink(0);
+
+/// Builds a tree of tasks with the given fan-out and runs it, returning seconds taken
+static f64 runTaskTree(TPSpawnTask::Owner& owner, size_t roots, size_t fanOut, size_t depth) {
+    // Lay out the tree breadth first so each task knows where its children live
+    size_t total = roots;
+    size_t level = roots;
+    for (size_t d = 0; d < depth; d++) {
+        level *= fanOut;
+        total += level;
+    }
+    owner.tasks.clear();
+    owner.tasks.resize(total);
+    size_t next = roots;
+    for (size_t i = 0; i < total; i++) {
+        TPSpawnTask& t = owner.tasks[i];
+        t.pool = &owner;
+        t.seed = (ui32)i;
+        if (next + fanOut <= total) {
+            t.firstChild = next;
+            t.children = fanOut;
+            next += fanOut;
+        }
+    }
+    owner.executed = 0;
+
+    PreciseTimer timer;
+    for (size_t i = 0; i < roots; i++) owner.threadPool.addTask(&owner.tasks[i]);
+    while (owner.executed < total) std::this_thread::yield();
+    return timer.stop();
+}
+
+TEST(WorkStealingCompletes) {
+    TPSpawnTask::Owner owner;
+    owner.threadPool.init(4, true);
+    runTaskTree(owner, 8, 4, 4);
+    owner.threadPool.destroy();
+
+    bool ok = owner.executed == owner.tasks.size();
+    for (auto& t : owner.tasks) ok &= t.isFinished;
+    return ok;
+}
+
+TEST(WorkStealingThroughput) {
+    ui32 workers = std::max(2u, std::thread::hardware_concurrency());
+
+    f64 sharedTime, stealingTime;
+    size_t tasks;
+    {
+        TPSpawnTask::Owner owner;
+        owner.threadPool.init(workers, false);
+        sharedTime = runTaskTree(owner, 16, 8, 4);
+        tasks = owner.tasks.size();
+        owner.threadPool.destroy();
+    }
+    {
+        TPSpawnTask::Owner owner;
+        owner.threadPool.init(workers, true);
+        stealingTime = runTaskTree(owner, 16, 8, 4);
+        owner.threadPool.destroy();
+    }
+
+    printf("%u workers, %u tasks\n", workers, (ui32)tasks);
+    printf("Shared queue:  %lf ms (%lf tasks/ms)\n", sharedTime, tasks / sharedTime);
+    printf("Work stealing: %lf ms (%lf tasks/ms)\n", stealingTime, tasks / stealingTime);
+    return true;
+}
+
+/// Records the order in which it ran
+class TPOrderTask : public vcore::IThreadPoolTask<TPWorkerData> {
+public:
+    virtual void execute(TPWorkerData* workerData VORB_UNUSED) override {
+        order = (*counter)++;
+    }
+
+    std::atomic<i32>* counter = nullptr;
+    i32 order = -1;
+};
+
+TEST(TaskGraphOrdering) {
+    TPool pool;
+    pool.init(4, true);
+    std::atomic<i32> counter(0);
+
+    // Diamond: a -> (b, c) -> d -> upload on this thread
+    TPOrderTask a, b, c, d;
+    a.counter = b.counter = c.counter = d.counter = &counter;
+
+    i32 uploadOrder = -1;
+    auto fUpload = makeFunctor([&] (Sender, void*) {
+        uploadOrder = counter++;
+    });
+    vcore::RPCManager rpcManager;
+    vcore::RPC rpc;
+    rpc.data.f = &fUpload;
+
+    vcore::TaskGraph<TPWorkerData> graph;
+    auto na = graph.addTask(&a);
+    auto nb = graph.addTask(&b);
+    auto nc = graph.addTask(&c);
+    auto nd = graph.addTask(&d);
+    auto nu = graph.addRPC(&rpcManager, &rpc);
+    graph.addDependency(na, nb);
+    graph.addDependency(na, nc);
+    graph.addDependency(nb, nd);
+    graph.addDependency(nc, nd);
+    graph.addDependency(nd, nu);
+
+    for (size_t run = 0; run < 100; run++) {
+        // Every run must record a fresh sequence, so stale results from the last run cannot pass
+        counter = 0;
+        a.order = b.order = c.order = d.order = uploadOrder = -1;
+        graph.submit(&pool);
+        while (!graph.isFinished()) rpcManager.processRequests();
+
+        if (counter != 5) return false;
+        if (a.order != 0) return false;
+        if (b.order <= a.order || c.order <= a.order || b.order == c.order) return false;
+        if (d.order != 3) return false;
+        if (uploadOrder != 4) return false;
+        if (!d.isFinished || rpc.data.f != &fUpload) return false;
+    }
+
+    pool.destroy();
+    return true;
+}
+
+TEST(TaskGraphWideFanIn) {
+    TPool pool;
+    pool.init(4, false);
+    std::atomic<i32> counter(0);
+
+    // Many independent producers feeding one consumer
+    std::vector<TPOrderTask> producers(1000);
+    TPOrderTask consumer;
+    consumer.counter = &counter;
+
+    vcore::TaskGraph<TPWorkerData> graph;
+    auto nConsumer = graph.addTask(&consumer);
+    for (auto& p : producers) {
+        p.counter = &counter;
+        graph.addDependency(graph.addTask(&p), nConsumer);
+    }
+    graph.submit(&pool);
+    while (!graph.isFinished()) std::this_thread::yield();
+
+    pool.destroy();
+    return consumer.order == (i32)producers.size();
+}
+
+TEST(TaskGraphCleared) {
+    // Nodes queued on a pool that has no workers yet are dropped by clearTasks
+    TPool pool;
+    std::atomic<i32> counter(0);
+    TPOrderTask first, second, third;
+    first.counter = second.counter = third.counter = &counter;
+
+    // The dropped node's successors are skipped with it, including one that also waits on another node
+    vcore::TaskGraph<TPWorkerData> graph;
+    auto nFirst = graph.addTask(&first);
+    auto nSecond = graph.addTask(&second);
+    auto nThird = graph.addTask(&third);
+    graph.addDependency(nFirst, nSecond);
+    graph.addDependency(nFirst, nThird);
+    graph.addDependency(nSecond, nThird);
+    graph.submit(&pool);
+    pool.clearTasks();
+    if (!graph.isFinished() || counter != 0) return false;
+    for (auto* t : { &first, &second, &third }) {
+        if (!t->wasSkipped || !t->isFinished) return false;
+    }
+
+    // The graph can be submitted again
+    pool.init(2);
+    graph.submit(&pool);
+    while (!graph.isFinished()) std::this_thread::yield();
+    pool.destroy();
+    return first.order == 0 && second.order == 1 && third.order == 2 && !third.wasSkipped;
+}
+
+TEST(TaskGraphCancellation) {
+    TPool pool;
+    pool.init(2);
+    std::atomic<i32> counter(0);
+
+    // b and c run as continuations of a, so they never pass through the pool's queue
+    TPOrderTask a, b, c;
+    a.counter = b.counter = c.counter = &counter;
+    vcore::TaskCancelToken token;
+    b.cancelToken = c.cancelToken = &token;
+    token.cancel();
+
+    vcore::TaskGraph<TPWorkerData> graph;
+    auto na = graph.addTask(&a);
+    auto nb = graph.addTask(&b);
+    auto nc = graph.addTask(&c);
+    graph.addDependency(na, nb);
+    graph.addDependency(nb, nc);
+    graph.submit(&pool);
+    while (!graph.isFinished()) std::this_thread::yield();
+    pool.destroy();
+
+    return a.order == 0 && !a.wasSkipped && b.wasSkipped && c.wasSkipped && counter == 1 &&
+        pool.getSkippedTaskCount() == 2;
+}
+
+/// Holds a worker until released
+class TPGateTask : public vcore::IThreadPoolTask<TPWorkerData> {
+public:
+    virtual void execute(TPWorkerData* workerData VORB_UNUSED) override {
+        started = true;
+        while (!open) std::this_thread::yield();
+    }
+
+    std::atomic<bool> started { false };
+    std::atomic<bool> open { false };
+};
+
+TEST(Priorities) {
+    for (int mode = 0; mode < 2; mode++) {
+        TPool pool;
+        pool.init(1, mode == 1);
+        std::atomic<i32> counter(0);
+
+        TPGateTask gate;
+        pool.addTask(&gate);
+        while (!gate.started) std::this_thread::yield();
+
+        // Queue low priority work before high priority work
+        std::vector<TPOrderTask> low(50), high(50);
+        for (auto& t : low) {
+            t.counter = &counter;
+            t.priority = vcore::TaskPriority::LOW;
+            pool.addTask(&t);
+        }
+        for (auto& t : high) {
+            t.counter = &counter;
+            t.priority = vcore::TaskPriority::HIGH;
+            pool.addTask(&t);
+        }
+        gate.open = true;
+        while (counter < 100) std::this_thread::yield();
+        pool.destroy();
+
+        for (auto& t : high) {
+            if (t.order >= (i32)high.size()) return false;
+        }
+    }
+    return true;
+}
+
+TEST(Cancellation) {
+    TPool pool;
+    pool.init(1);
+    std::atomic<i32> counter(0);
+
+    TPGateTask gate;
+    pool.addTask(&gate);
+    while (!gate.started) std::this_thread::yield();
+
+    // Half the tasks belong to a region that gets unloaded before they run
+    vcore::TaskCancelToken unloaded;
+    std::vector<TPOrderTask> tasks(100);
+    for (size_t i = 0; i < tasks.size(); i++) {
+        tasks[i].counter = &counter;
+        if (i & 1) tasks[i].cancelToken = &unloaded;
+        pool.addTask(&tasks[i]);
+    }
+    unloaded.cancel();
+    gate.open = true;
+
+    for (auto& t : tasks) {
+        while (!t.isFinished) std::this_thread::yield();
+    }
+    pool.destroy();
+
+    for (size_t i = 0; i < tasks.size(); i++) {
+        bool cancelled = (i & 1) != 0;
+        if (tasks[i].wasSkipped != cancelled) return false;
+        if (cancelled != (tasks[i].order == -1)) return false;
+    }
+    printf("Skipped %u of %u tasks\n", (ui32)pool.getSkippedTaskCount(), (ui32)tasks.size());
+    return pool.getSkippedTaskCount() == tasks.size() / 2 && counter == (i32)tasks.size() / 2;
+}
+
+TEST(ParallelFor) {
+    TPool pool;
+    pool.init(4);
+
+    // Every index is visited exactly once, including ranges smaller than the pool
+    const size_t sizes[] = { 0, 1, 3, 1000, 100003 };
+    for (size_t size : sizes) {
+        std::vector<std::atomic<ui32>> hits(size);
+        for (auto& h : hits) h = 0;
+        vcore::parallelFor(pool, 0, size, 16, [&] (size_t b, size_t e) {
+            for (size_t i = b; i < e; i++) hits[i]++;
+        });
+        for (auto& h : hits) {
+            if (h != 1) return false;
+        }
+    }
+
+    // Usable from inside a task running on the same pool
+    struct NestedTask : public vcore::IThreadPoolTask<TPWorkerData> {
+        virtual void execute(TPWorkerData* workerData VORB_UNUSED) override {
+            vcore::parallelFor(*pool, 0, 10000, 64, [&] (size_t b, size_t e) { sum += e - b; });
+        }
+        TPool* pool;
+        std::atomic<size_t> sum;
+    } nested;
+    nested.pool = &pool;
+    nested.sum = 0;
+    pool.addTask(&nested);
+    while (!nested.isFinished) std::this_thread::yield();
+
+    pool.destroy();
+    return nested.sum == 10000;
+}
+
+TEST(ParallelForBusyPool) {
+    // The only worker is busy, so the helper is still queued when the caller runs out of chunks
+    TPool pool;
+    pool.init(1);
+    TPGateTask gate;
+    pool.addTask(&gate);
+    while (!gate.started) std::this_thread::yield();
+
+    // The caller does not wait for the helper
+    std::atomic<size_t> sum(0);
+    vcore::parallelFor(pool, 0, 1000, 1, [&] (size_t b, size_t e) { sum += e - b; });
+    if (sum != 1000 || pool.getTasksSizeApprox() == 0) return false;
+
+    // Clearing hands the stale helper back, which frees the job
+    pool.clearTasks();
+    gate.open = true;
+    pool.destroy();
+    return true;
+}
+
+TEST(ParallelReduce) {
+    TPool pool;
+    pool.init(4);
+
+    std::vector<ui32> values(1 << 20);
+    for (size_t i = 0; i < values.size(); i++) values[i] = (ui32)(i * 2654435761u) >> 20;
+    ui64 expected = 0;
+    for (auto& v : values) expected += v;
+
+    auto sum = [&] (size_t b, size_t e) {
+        ui64 s = 0;
+        for (size_t i = b; i < e; i++) s += values[i];
+        return s;
+    };
+    auto add = [] (const ui64& a, const ui64& b) { return a + b; };
+
+    PreciseTimer timer;
+    ui64 result = 0;
+    for (size_t i = 0; i < 20; i++) result = vcore::parallelReduce(pool, 0, values.size(), 4096, (ui64)0, sum, add);
+    f64 ms = timer.stop();
+    printf("parallelReduce over %u values: %lf ms\n", (ui32)values.size(), ms / 20.0);
+
+    pool.destroy();
+    return result == expected;
+}
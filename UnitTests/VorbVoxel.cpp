@@ -4,7 +4,16 @@
 #undef UNIT_TEST_BATCH
 #define UNIT_TEST_BATCH Vorb_Voxel_
 
+#include <algorithm>
+#include <random>
+
 #include <include/voxel/IntervalTree.h>
+#include <include/voxel/PaddedChunk.h>
+#include <include/voxel/PaletteContainer.h>
+#include <include/voxel/VoxelMesherCulled.h>
+#include <include/voxel/VoxelMipChain.h>
+#include <include/voxel/VoxelRay.h>
+#include <include/voxel/VoxelTextureStitcher.h>
 #include <include/Vorb.h>
 #include <include/Timing.h>
 
@@ -75,4 +84,722 @@ TEST(IntervalTree) {
 
     std::cout << tree.size() << std::endl;
     return true;
-}
\ No newline at end of file
+}
+
+TEST(IntervalTreeVolume) {
+    // A 64^3 chunk no longer fits 16-bit starts
+    const size_t VOLUME = 64 * 64 * 64;
+    IntervalTree<ui16> tree(VOLUME);
+    tree.reserve(VOLUME / 4);
+    size_t capacity = tree.capacity();
+
+    std::vector<ui16> reference(VOLUME);
+    std::vector<IntervalTree<ui16>::LNode> runs;
+    for (size_t i = 0; i < VOLUME; i += 4096) {
+        runs.emplace_back((ui32)i, 4096, (ui16)(i / 4096 % 3));
+        std::fill_n(reference.begin() + i, 4096, (ui16)(i / 4096 % 3));
+    }
+
+    std::mt19937 rng(5);
+    std::vector<ui16> buffer(VOLUME);
+    for (int cycle = 0; cycle < 4; cycle++) {
+        tree.initFromSortedArray(runs);
+        std::vector<ui16> expected = reference;
+        PreciseTimer timer;
+        for (int i = 0; i < 20000; i++) {
+            size_t index = rng() % VOLUME;
+            ui16 value = (ui16)(rng() % 4);
+            tree.insert(index, value);
+            expected[index] = value;
+        }
+        f64 insertTime = timer.stop();
+        timer.start();
+        tree.uncompressIntoBuffer(buffer.data());
+        printf("64^3 tree, %u intervals: 20000 inserts %lf ms, uncompress %lf ms\n", (ui32)tree.size(), insertTime, timer.stop());
+
+        if (!tree.checkTreeValidity() || buffer != expected) return false;
+        for (size_t i = 0; i < VOLUME; i += 997) {
+            if (tree.getData(i) != expected[i]) return false;
+        }
+    }
+    // Every cycle reused the reserved nodes
+    return tree.capacity() == capacity;
+}
+
+TEST(IntervalTreeFill) {
+    const size_t VOLUME = 32 * 32 * 32;
+    std::mt19937 rng(13);
+    std::vector<ui16> initial(VOLUME);
+    for (size_t i = 0; i < VOLUME; i++) initial[i] = (ui16)((i / 700) % 3);
+    std::vector<IntervalTree<ui16>::LNode> runs;
+    for (size_t i = 0; i < VOLUME; i++) {
+        if (i == 0 || initial[i] != initial[i - 1]) runs.emplace_back((ui32)i, 0, initial[i]);
+        runs.back().length++;
+    }
+
+    IntervalTree<ui16> filled(VOLUME), inserted(VOLUME);
+    filled.initFromSortedArray(runs);
+    inserted.initFromSortedArray(runs);
+    std::vector<ui16> a(VOLUME), b(VOLUME);
+
+    // Ranges, including ones that touch or cover existing intervals
+    for (int i = 0; i < 200; i++) {
+        size_t start = rng() % VOLUME;
+        size_t end = std::min(VOLUME, start + 1 + rng() % 2000);
+        ui16 value = (ui16)(rng() % 4);
+        filled.fillRange(start, end, value);
+        for (size_t j = start; j < end; j++) inserted.insert(j, value);
+    }
+    filled.uncompressIntoBuffer(a.data());
+    inserted.uncompressIntoBuffer(b.data());
+    if (a != b || !filled.checkTreeValidity()) return false;
+
+    // Placing 16^3 structures
+    f64 fillTime = 0.0, insertTime = 0.0;
+    for (int i = 0; i < 8; i++) {
+        ui32v3 min(rng() % 17, rng() % 17, rng() % 17);
+        ui32v3 max = min + ui32v3(16);
+        ui16 value = (ui16)(5 + i % 3);
+        PreciseTimer timer;
+        filled.fillBox(min, max, value);
+        fillTime += timer.stop();
+        timer.start();
+        for (ui32 y = min.y; y < max.y; y++) {
+            for (ui32 z = min.z; z < max.z; z++) {
+                for (ui32 x = min.x; x < max.x; x++) inserted.insert(y * 1024 + z * 32 + x, value);
+            }
+        }
+        insertTime += timer.stop();
+    }
+    printf("8 16^3 boxes: fillBox %lf ms, per-voxel insert %lf ms\n", fillTime, insertTime);
+    filled.uncompressIntoBuffer(a.data());
+    inserted.uncompressIntoBuffer(b.data());
+    return a == b && filled.checkTreeValidity();
+}
+
+TEST(PaletteContainer) {
+    const size_t VOLUME = 32768;
+    vvox::PaletteContainer<ui16> container(VOLUME);
+    std::vector<ui16> expected(VOLUME, 0);
+    std::vector<ui16> buffer(VOLUME);
+    std::mt19937 rng(3);
+
+    // Widen from a single value up to 16-bit indices
+    const ui32 RANGES[4] = { 2, 16, 200, 3000 };
+    const ui32 WIDTHS[4] = { 4, 4, 8, 16 };
+    for (size_t r = 0; r < 4; r++) {
+        for (int i = 0; i < 40000; i++) {
+            size_t index = rng() % VOLUME;
+            ui16 value = (ui16)(rng() % RANGES[r]);
+            container.insert(index, value);
+            expected[index] = value;
+        }
+        if (container.isRLE() || container.getBitsPerIndex() != WIDTHS[r]) return false;
+        container.uncompressIntoBuffer(buffer.data());
+        if (buffer != expected) return false;
+        for (size_t i = 0; i < VOLUME; i += 31) {
+            if (container.getData(i) != expected[i]) return false;
+        }
+    }
+
+    // Long runs are stored as runs until edits break them up
+    for (size_t i = 0; i < VOLUME; i++) expected[i] = (ui16)(i / 1024);
+    container.initFromBuffer(expected.data());
+    if (!container.isRLE() || container.getRunCount() != 32) return false;
+    for (int i = 0; i < 20000; i++) {
+        size_t index = rng() % VOLUME;
+        ui16 value = (ui16)(rng() % 4);
+        container.insert(index, value);
+        expected[index] = value;
+        if (container.getData(index) != value) return false;
+    }
+    if (container.isRLE()) return false;
+    container.uncompressIntoBuffer(buffer.data());
+    if (buffer != expected) return false;
+
+    // Compacting drops palette entries that are no longer used
+    for (size_t i = 0; i < VOLUME; i++) container.insert(i, (ui16)(i & 1));
+    container.compact();
+    return container.getPaletteSize() == 2 && container.getBitsPerIndex() == 4;
+}
+
+TEST(PaletteContainerBenchmark) {
+    const size_t VOLUME = 32 * 32 * 32;
+    const size_t READS = 1000000;
+    std::mt19937 rng(9);
+
+    std::vector<ui32> reads(READS);
+    for (auto& r : reads) r = rng() % VOLUME;
+
+    const char* NAMES[3] = { "Random", "Layered", "Solid" };
+    std::vector<ui16> data(VOLUME);
+    std::vector<ui16> buffer(VOLUME);
+    for (int set = 0; set < 3; set++) {
+        for (size_t i = 0; i < VOLUME; i++) {
+            switch (set) {
+            case 0: data[i] = (ui16)(rng() % 12); break;
+            case 1: data[i] = (ui16)(i / (32 * 32 * 4)); break;
+            default: data[i] = 1; break;
+            }
+        }
+
+        std::vector<IntervalTree<ui16>::LNode> runs;
+        for (size_t i = 0; i < VOLUME; i++) {
+            if (i == 0 || data[i] != data[i - 1]) runs.emplace_back((ui32)i, 0, data[i]);
+            runs.back().length++;
+        }
+        IntervalTree<ui16> tree(VOLUME);
+        tree.initFromSortedArray(runs);
+        vvox::PaletteContainer<ui16> container(VOLUME);
+        container.initFromBuffer(data.data());
+
+        container.uncompressIntoBuffer(buffer.data());
+        if (buffer != data) return false;
+
+        ui32 sum1 = 0, sum2 = 0;
+        PreciseTimer timer;
+        for (auto r : reads) sum1 += tree.getData(r);
+        f64 treeTime = timer.stop();
+        timer.start();
+        for (auto r : reads) sum2 += container.getData(r);
+        f64 containerTime = timer.stop();
+        if (sum1 != sum2) return false;
+
+        size_t treeBytes = sizeof(tree) + tree.capacity() * sizeof(IntervalTree<ui16>::Node);
+        printf("%s 32^3: IntervalTree %u bytes, %lf ns/read | PaletteContainer (%s, %u bits) %u bytes, %lf ns/read\n",
+               NAMES[set], (ui32)treeBytes, treeTime * 1e6 / READS,
+               container.isRLE() ? "runs" : "palette", container.getBitsPerIndex(),
+               (ui32)container.getMemoryUsage(), containerTime * 1e6 / READS);
+    }
+    return true;
+}
+
+namespace {
+    /// Solid voxels are non-zero and merge with voxels of the same value
+    class TestMesherAPI {
+    public:
+        vvox::meshalg::VoxelFaces occludes(const ui16& v1, const ui16& v2, const vvox::Axis& axis VORB_UNUSED) const {
+            vvox::meshalg::VoxelFaces f;
+            f.block1Face = v1 != 0 && v2 == 0;
+            f.block2Face = v2 != 0 && v1 == 0;
+            return f;
+        }
+        bool isOpaque(const ui16& v) const {
+            return v != 0;
+        }
+        ui32 mergeKey(const ui16& v, const vvox::Cardinal& direction VORB_UNUSED) const {
+            return v;
+        }
+        void result(const vvox::meshalg::VoxelQuad& q) {
+            quads.push_back(q);
+        }
+
+        /// Expand quads into unit faces, keyed by voxel index and direction
+        std::vector<ui64> unitFaces(const ui32v3& size) const {
+            static const ui32v3 SWEEPS[3] = { ui32v3(0, 2, 1), ui32v3(1, 0, 2), ui32v3(2, 0, 1) };
+            std::vector<ui64> faces;
+            for (auto& q : quads) {
+                const ui32v3& sweep = SWEEPS[(size_t)vvox::toAxis(q.direction)];
+                for (ui32 v = 0; v < q.size.y; v++) {
+                    for (ui32 u = 0; u < q.size.x; u++) {
+                        ui32v3 p = q.voxelPosition;
+                        p[sweep.y] += u;
+                        p[sweep.z] += v;
+                        ui64 index = p.y * size.x * size.z + p.z * size.x + p.x;
+                        faces.push_back((index << 3) | (ui64)q.direction);
+                    }
+                }
+            }
+            std::sort(faces.begin(), faces.end());
+            return faces;
+        }
+
+        std::vector<vvox::meshalg::VoxelQuad> quads;
+    };
+
+    /// Mesher API that keeps its own occupancy bitmasks, one word per X row
+    class TestOccupancyAPI : public TestMesherAPI {
+    public:
+        TestOccupancyAPI(const ui16* data, const ui32v3& size) : size(size) {
+            rows.resize(size.y * size.z);
+            for (size_t i = 0; i < rows.size(); i++) {
+                for (ui32 x = 0; x < size.x; x++) {
+                    if (data[i * size.x + x]) rows[i] |= 1ull << x;
+                }
+            }
+        }
+        ui64 getOccupancy(ui32 y, ui32 z) const {
+            return rows[y * size.z + z];
+        }
+
+        ui32v3 size;
+        std::vector<ui64> rows;
+    };
+}
+
+TEST(GreedyMeshing) {
+    // A flat 32x32 layer inside a padded 34^3 array
+    const ui32v3 SIZE(34, 34, 34);
+    std::vector<ui16> data(SIZE.x * SIZE.y * SIZE.z, 0);
+    for (ui32 z = 1; z < 33; z++) {
+        for (ui32 x = 1; x < 33; x++) data[1 * SIZE.x * SIZE.z + z * SIZE.x + x] = 1;
+    }
+
+    TestMesherAPI culled, greedy;
+    vvox::meshalg::createCulled(data.data(), SIZE, &culled);
+    vvox::meshalg::createGreedy(data.data(), SIZE, &greedy);
+    printf("Flat layer: %u culled quads, %u greedy quads\n", (ui32)culled.quads.size(), (ui32)greedy.quads.size());
+    if (greedy.quads.size() != 6) return false;
+    return culled.unitFaces(SIZE) == greedy.unitFaces(SIZE);
+}
+
+TEST(GreedyMeshingCoverage) {
+    const ui32v3 SIZE(18, 20, 22);
+    std::vector<ui16> data(SIZE.x * SIZE.y * SIZE.z);
+    std::mt19937 rng(7);
+    for (auto& v : data) v = (rng() % 4 == 0) ? 0 : (ui16)(1 + rng() % 3);
+
+    TestMesherAPI culled, greedy;
+    vvox::meshalg::createCulled(data.data(), SIZE, &culled);
+    PreciseTimer timer;
+    vvox::meshalg::createGreedy(data.data(), SIZE, &greedy);
+    printf("Random volume: %u culled quads, %u greedy quads in %lf ms\n", (ui32)culled.quads.size(), (ui32)greedy.quads.size(), timer.stop());
+    if (greedy.quads.size() > culled.quads.size()) return false;
+    if (culled.unitFaces(SIZE) != greedy.unitFaces(SIZE)) return false;
+
+    // Merged quads never mix voxel values
+    for (auto& q : greedy.quads) {
+        ui16 value = data[q.startIndex];
+        std::vector<vvox::meshalg::VoxelQuad> single(1, q);
+        TestMesherAPI one;
+        one.quads = single;
+        for (ui64 f : one.unitFaces(SIZE)) {
+            if (data[f >> 3] != value) return false;
+        }
+    }
+    return true;
+}
+
+TEST(BitmaskCulling) {
+    const ui32v3 SIZE(34, 34, 34);
+    std::vector<ui16> data(SIZE.x * SIZE.y * SIZE.z);
+    std::mt19937 rng(11);
+
+    // Random, mostly air and mostly stone volumes
+    const ui32 SOLID_CHANCES[3] = { 50, 3, 97 };
+    const char* NAMES[3] = { "Random", "Mostly air", "Mostly stone" };
+    for (size_t i = 0; i < 3; i++) {
+        for (auto& v : data) v = (rng() % 100 < SOLID_CHANCES[i]) ? 1 : 0;
+
+        TestMesherAPI culled, bitmask;
+        PreciseTimer timer;
+        vvox::meshalg::createCulled(data.data(), SIZE, &culled);
+        f64 culledTime = timer.stop();
+        timer.start();
+        vvox::meshalg::createCulledBitmask(data.data(), SIZE, &bitmask);
+        f64 bitmaskTime = timer.stop();
+        printf("%s: %u quads, culled %lf ms, bitmask %lf ms\n", NAMES[i], (ui32)bitmask.quads.size(), culledTime, bitmaskTime);
+
+        if (culled.unitFaces(SIZE) != bitmask.unitFaces(SIZE)) return false;
+
+        // Bitmasks kept by the API replace the voxel data
+        TestOccupancyAPI occupancy(data.data(), SIZE);
+        vvox::meshalg::createCulledBitmask((const ui16*)nullptr, SIZE, &occupancy);
+        if (occupancy.unitFaces(SIZE) != bitmask.unitFaces(SIZE)) return false;
+        for (auto& q : bitmask.quads) {
+            if (q.startIndex != q.voxelPosition.y * SIZE.x * SIZE.z + q.voxelPosition.z * SIZE.x + q.voxelPosition.x) return false;
+        }
+    }
+    return true;
+}
+
+TEST(PaddedChunkMeshing) {
+    // A 3x3x3 grid of 16^3 chunks cut from one world
+    const ui32 WIDTH = 16;
+    const ui32 WORLD = WIDTH * 3;
+    const size_t CHUNK_VOLUME = WIDTH * WIDTH * WIDTH;
+    std::vector<ui16> world(WORLD * WORLD * WORLD);
+    std::mt19937 rng(23);
+    for (size_t i = 0; i < world.size(); i++) {
+        ui32 y = (ui32)(i / (WORLD * WORLD));
+        world[i] = (y < 20 + rng() % 8 && rng() % 4) ? (ui16)(1 + rng() % 2) : 0;
+    }
+    auto worldAt = [&] (const i32v3& p) { return world[p.y * WORLD * WORLD + p.z * WORLD + p.x]; };
+
+    auto makeChunk = [&] (const i32v3& chunk) {
+        std::vector<IntervalTree<ui16>::LNode> runs;
+        for (ui32 i = 0; i < CHUNK_VOLUME; i++) {
+            i32v3 p = chunk * (i32)WIDTH + i32v3(i % WIDTH, i / (WIDTH * WIDTH), (i / WIDTH) % WIDTH);
+            ui16 v = worldAt(p);
+            if (runs.empty() || runs.back().data != v) runs.emplace_back(i, 0, v);
+            runs.back().length++;
+        }
+        IntervalTree<ui16> tree(CHUNK_VOLUME);
+        tree.initFromSortedArray(runs);
+        return tree;
+    };
+    const i32v3 OFFSETS[6] = { i32v3(0, 1, 1), i32v3(2, 1, 1), i32v3(1, 0, 1), i32v3(1, 2, 1), i32v3(1, 1, 0), i32v3(1, 1, 2) };
+    IntervalTree<ui16> center = makeChunk(i32v3(1, 1, 1));
+    IntervalTree<ui16> neighbours[6];
+    const IntervalTree<ui16>* pointers[6];
+    for (size_t i = 0; i < 6; i++) {
+        neighbours[i] = makeChunk(OFFSETS[i]);
+        pointers[i] = &neighbours[i];
+    }
+
+    const ui32 P = WIDTH + 2;
+    const ui32v3 SIZE(P, P, P);
+    std::vector<ui16> padded(P * P * P);
+    PreciseTimer timer;
+    vvox::buildPaddedChunk(center, pointers, WIDTH, padded.data(), (ui16)0xFFFF);
+    printf("Padded chunk built in %lf ms\n", timer.stop());
+
+    // Faces come from the world, edges and corners stay filled
+    for (ui32 y = 0; y < P; y++) {
+        for (ui32 z = 0; z < P; z++) {
+            for (ui32 x = 0; x < P; x++) {
+                ui32 outside = (x == 0 || x == P - 1) + (y == 0 || y == P - 1) + (z == 0 || z == P - 1);
+                ui16 expected = (outside > 1) ? 0xFFFF : worldAt(i32v3(x, y, z) + (i32)WIDTH - 1);
+                if (padded[y * P * P + z * P + x] != expected) return false;
+            }
+        }
+    }
+
+    // Border faces match meshing the same region of the world directly
+    std::vector<ui16> direct(padded.size(), 0);
+    for (ui32 i = 0; i < direct.size(); i++) {
+        i32v3 p(i % P, i / (P * P), (i / P) % P);
+        direct[i] = worldAt(p + (i32)WIDTH - 1);
+    }
+    TestMesherAPI chunkMesh, worldMesh;
+    vvox::meshalg::createCulled(padded.data(), SIZE, &chunkMesh);
+    vvox::meshalg::createCulled(direct.data(), SIZE, &worldMesh);
+    if (chunkMesh.unitFaces(SIZE) != worldMesh.unitFaces(SIZE)) return false;
+
+    // The full neighbourhood also fills edges and corners, which AO meshing reads
+    IntervalTree<ui16> around[27];
+    const IntervalTree<ui16>* aroundPointers[27];
+    for (i32 dy = -1; dy <= 1; dy++) {
+        for (i32 dz = -1; dz <= 1; dz++) {
+            for (i32 dx = -1; dx <= 1; dx++) {
+                ui32 index = vvox::paddedNeighbourIndex(dx, dy, dz);
+                around[index] = makeChunk(i32v3(dx, dy, dz) + 1);
+                aroundPointers[index] = &around[index];
+            }
+        }
+    }
+    aroundPointers[vvox::paddedNeighbourIndex(0, 0, 0)] = nullptr;
+    timer.start();
+    vvox::buildPaddedNeighbourhood(center, aroundPointers, WIDTH, padded.data(), (ui16)0xFFFF);
+    printf("Padded neighbourhood built in %lf ms\n", timer.stop());
+    if (padded != direct) return false;
+
+    // Missing neighbours leave their face filled
+    pointers[(size_t)vvox::Cardinal::Y_POS] = nullptr;
+    vvox::buildPaddedChunk(center, pointers, WIDTH, padded.data(), (ui16)7);
+    for (ui32 i = 0; i < P * P; i++) {
+        if (padded[(P - 1) * P * P + i] != 7) return false;
+    }
+    aroundPointers[vvox::paddedNeighbourIndex(1, 1, 1)] = nullptr;
+    vvox::buildPaddedNeighbourhood(center, aroundPointers, WIDTH, padded.data(), (ui16)7);
+    if (padded.back() != 7 || padded[P * P * P - 2] != worldAt(i32v3(P - 2, P - 1, P - 1) + (i32)WIDTH - 1)) return false;
+    return true;
+}
+
+TEST(VoxelMipChain) {
+    // Reductions of single blocks
+    const ui16 BLOCK[8] = { 0, 2, 3, 3, 2, 0, 5, 0 };
+    if (vvox::MajorityReduction<ui16>()(BLOCK) != 0) return false;
+    const ui16 TIE[8] = { 4, 4, 1, 1, 7, 7, 0, 2 };
+    if (vvox::MajorityReduction<ui16>()(TIE) != 4) return false;
+    auto priority = vvox::makePriorityReduction<ui16>([] (const ui16& v) { return v == 5 ? 100 : (i32)v; });
+    if (priority(BLOCK) != 5) return false;
+    auto firstSolid = vvox::makeFirstSolidReduction<ui16>([] (const ui16& v) { return v != 0; });
+    if (firstSolid(BLOCK) != 2) return false;
+    const ui16 AIR[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+    if (firstSolid(AIR) != 0) return false;
+
+    // Terrain with a flat surface and scattered ores
+    const ui32 WIDTH = 32;
+    const ui32v3 SIZE(WIDTH);
+    std::vector<ui16> data(WIDTH * WIDTH * WIDTH);
+    std::mt19937 rng(31);
+    for (size_t i = 0; i < data.size(); i++) {
+        ui32 y = (ui32)(i / (WIDTH * WIDTH));
+        data[i] = (y < 16) ? ((rng() % 50 == 0) ? 3 : 1) : 0;
+    }
+    std::vector<IntervalTree<ui16>::LNode> runs;
+    for (ui32 i = 0; i < data.size(); i++) {
+        if (runs.empty() || runs.back().data != data[i]) runs.emplace_back(i, 0, data[i]);
+        runs.back().length++;
+    }
+    IntervalTree<ui16> tree(data.size());
+    tree.initFromSortedArray(runs);
+
+    // Dense and compressed sources give the same levels, and rebuilding gives the same result
+    vvox::VoxelMipChain<ui16> dense, compressed;
+    PreciseTimer timer;
+    dense.build(data.data(), SIZE, 3, vvox::MajorityReduction<ui16>());
+    printf("32^3 mip chain built in %lf ms\n", timer.stop());
+    compressed.build(tree, WIDTH, 3, vvox::MajorityReduction<ui16>());
+    if (dense.getLevels() != 3 || compressed.getLevels() != 3) return false;
+    for (ui32 l = 0; l < 3; l++) {
+        size_t volume = (size_t)WIDTH * WIDTH * WIDTH >> (3 * l);
+        if (dense.getSize(l) != SIZE / (1u << l)) return false;
+        if (!std::equal(dense.getLevel(l), dense.getLevel(l) + volume, compressed.getLevel(l))) return false;
+    }
+    if (!std::equal(dense.getLevel(0), dense.getLevel(0) + data.size(), data.begin())) return false;
+    // Majority drops the rare ores that priority keeps
+    const ui16* majority1 = dense.getLevel(1);
+    if (std::count(majority1, majority1 + 16 * 16 * 16, 3)) return false;
+    vvox::VoxelMipChain<ui16> ores;
+    ores.build(data.data(), SIZE, 2, priority);
+    const ui16* priority1 = ores.getLevel(1);
+    if (!std::count(priority1, priority1 + 16 * 16 * 16, 3)) return false;
+
+    // Each level meshes 1/8 of the voxels and a quarter of the faces of the one before
+    size_t faces[3];
+    for (ui32 l = 0; l < 3; l++) {
+        ui32v3 padded = dense.getSize(l) + 2u;
+        std::vector<ui16> buffer(padded.x * padded.y * padded.z);
+        dense.copyPadded(l, buffer.data(), 0);
+        TestMesherAPI api;
+        vvox::meshalg::createCulled(buffer.data(), padded, &api);
+        faces[l] = api.quads.size();
+        printf("Level %u: %u voxels, %u faces\n", l, (ui32)(padded.x - 2) * (padded.y - 2) * (padded.z - 2), (ui32)faces[l]);
+    }
+    return faces[0] == 2 * 32 * 32 + 4 * 32 * 16 && faces[1] * 4 == faces[0] && faces[2] * 16 == faces[0];
+}
+
+namespace {
+    /// Records faces with their neighbourhood and checks it against direct lookups
+    class TestAOAPI {
+    public:
+        TestAOAPI(const ui16* data, const ui32v3& size) : data(data), size(size) {}
+
+        bool isOpaque(const ui16& v) const {
+            return v != 0;
+        }
+        void resultAO(const vvox::meshalg::VoxelQuad& q, ui16 neighbours) {
+            static const ui32v3 SWEEPS[3] = { ui32v3(0, 2, 1), ui32v3(1, 0, 2), ui32v3(2, 0, 1) };
+            const ui32v3& sweep = SWEEPS[(size_t)vvox::toAxis(q.direction)];
+            i32v3 front(q.voxelPosition);
+            front[sweep.x] += ((q.direction & vvox::Cardinal::POSITIVE) == vvox::Cardinal::POSITIVE) ? 1 : -1;
+
+            ui16 expected = 0;
+            for (i32 v = -1; v <= 1; v++) {
+                for (i32 u = -1; u <= 1; u++) {
+                    i32v3 p = front;
+                    p[sweep.y] += u;
+                    p[sweep.z] += v;
+                    if (data[p.y * size.x * size.z + p.z * size.x + p.x]) expected |= 1 << VOXEL_NEIGHBOUR_BIT(u, v);
+                }
+            }
+            if (expected != neighbours) mismatches++;
+            quads.push_back(q);
+            ao.push_back(vvox::meshalg::computeAO(neighbours));
+        }
+
+        const ui16* data;
+        ui32v3 size;
+        size_t mismatches = 0;
+        std::vector<vvox::meshalg::VoxelQuad> quads;
+        std::vector<ui8> ao;
+    };
+}
+
+TEST(AmbientOcclusion) {
+    // Corner values of the reference calculation
+    if (vvox::meshalg::computeAO(0) != 0xFF) return false;
+    if (vvox::meshalg::computeAO(0x1FF) != 0x00) return false;
+    ui16 diagonal = 1 << VOXEL_NEIGHBOUR_BIT(-1, -1);
+    if (vvox::meshalg::computeAO(diagonal) != 0xFE) return false;
+    ui16 sides = (1 << VOXEL_NEIGHBOUR_BIT(1, 0)) | (1 << VOXEL_NEIGHBOUR_BIT(0, 1));
+    if (vvox::meshalg::computeAO(sides) != ((3 << 0) | (2 << 2) | (2 << 4) | (0 << 6))) return false;
+
+    const ui32v3 SIZE(34, 34, 34);
+    std::vector<ui16> data(SIZE.x * SIZE.y * SIZE.z);
+    std::mt19937 rng(21);
+    for (size_t i = 0; i < data.size(); i++) {
+        // Rolling terrain with caves
+        ui32 y = (ui32)(i / (SIZE.x * SIZE.z));
+        data[i] = (y < 12 + rng() % 6 && rng() % 5) ? 1 : 0;
+    }
+
+    TestAOAPI ao(data.data(), SIZE);
+    PreciseTimer timer;
+    vvox::meshalg::createCulledAO(data.data(), SIZE, &ao);
+    printf("AO meshing with per-face checks: %u faces in %lf ms\n", (ui32)ao.quads.size(), timer.stop());
+    if (ao.mismatches) return false;
+
+    // Same faces as the plain bitmask mesher
+    TestMesherAPI plain;
+    vvox::meshalg::createCulledBitmask(data.data(), SIZE, &plain);
+    TestMesherAPI faces;
+    faces.quads = ao.quads;
+    return faces.unitFaces(SIZE) == plain.unitFaces(SIZE);
+}
+
+namespace {
+    /// @return Length of the part of a ray inside a voxel, negative if it misses
+    f64 rayOverlap(const vvox::VoxelRay& ray, const i32v3& voxel) {
+        f64v3 d = ray.direction / glm::length(ray.direction);
+        f64 t0 = 0.0, t1 = ray.maxDistance;
+        for (i32 i = 0; i < 3; i++) {
+            if (d[i] == 0.0) {
+                if (ray.origin[i] < voxel[i] || ray.origin[i] >= voxel[i] + 1) return -1.0;
+                continue;
+            }
+            f64 a = (voxel[i] - ray.origin[i]) / d[i];
+            f64 b = (voxel[i] + 1 - ray.origin[i]) / d[i];
+            t0 = std::max(t0, std::min(a, b));
+            t1 = std::min(t1, std::max(a, b));
+        }
+        return t1 - t0;
+    }
+}
+
+TEST(VoxelRaycast) {
+    const f64 SAMPLE_STEP = 1e-4;
+    std::mt19937 rng(29);
+    std::uniform_real_distribution<f64> coord(-20.0, 20.0);
+
+    // Compare walks with fine fixed-step sampling
+    for (int r = 0; r < 200; r++) {
+        vvox::VoxelRay ray;
+        ray.origin = f64v3(coord(rng), coord(rng), coord(rng));
+        ray.direction = f64v3(coord(rng), coord(rng), coord(rng));
+        // Some rays lie on an axis or a plane
+        if (r % 10 == 0) ray.direction.y = 0.0;
+        if (r % 20 == 0) ray.direction.x = 0.0;
+        ray.maxDistance = 1.0 + (rng() % 30);
+
+        std::vector<i32v3> walked;
+        bool valid = true;
+        vvox::traceRay(ray, [&] (const i32v3& voxel, const vvox::Cardinal& face, f64 distance, ui32 steps) {
+            if (steps) {
+                // Each step enters a face neighbour through the shared face
+                i32v3 delta = voxel - walked.back();
+                if (std::abs(delta.x) + std::abs(delta.y) + std::abs(delta.z) != 1) valid = false;
+                i32 axis = (i32)vvox::toAxis(face);
+                if (delta[axis] == 0 || (delta[axis] > 0) != ((face & vvox::Cardinal::POSITIVE) == vvox::Cardinal::NEGATIVE)) valid = false;
+                f64v3 entry = ray.origin + ray.direction / glm::length(ray.direction) * distance;
+                if (std::abs(entry[axis] - (delta[axis] > 0 ? voxel[axis] : voxel[axis] + 1)) > 1e-6) valid = false;
+            }
+            walked.push_back(voxel);
+            return false;
+        });
+        if (!valid) return false;
+
+        // Every walked voxel touches the ray, and sampling finds no voxel the walk skipped
+        for (auto& v : walked) {
+            if (rayOverlap(ray, v) < -1e-9) return false;
+        }
+        f64v3 d = ray.direction / glm::length(ray.direction);
+        size_t next = 0;
+        for (f64 t = 0.0; t < ray.maxDistance; t += SAMPLE_STEP) {
+            f64v3 p = ray.origin + d * t;
+            i32v3 v(std::floor(p.x), std::floor(p.y), std::floor(p.z));
+            while (walked[next] != v) {
+                if (++next == walked.size()) return false;
+                // Sampling may only step over voxels the ray barely clips
+                if (walked[next] != v && rayOverlap(ray, walked[next]) > SAMPLE_STEP * 2) return false;
+            }
+        }
+    }
+
+    // Raycasts against a sparse world stop at the first solid voxel
+    auto isSolid = [] (const i32v3& v) {
+        return ((v.x * 7 + v.y * 13 + v.z * 31) & 63) == 0;
+    };
+    std::vector<vvox::VoxelRay> rays(20000);
+    for (auto& ray : rays) {
+        ray.origin = f64v3(coord(rng), coord(rng), coord(rng));
+        ray.direction = f64v3(coord(rng), coord(rng), coord(rng));
+        ray.maxDistance = 32.0;
+    }
+    std::vector<vvox::VoxelRayHit> hits(rays.size());
+    PreciseTimer timer;
+    size_t numHits = vvox::raycastMany(rays.data(), rays.size(), isSolid, hits.data());
+    printf("%u of %u rays hit in %lf ms\n", (ui32)numHits, (ui32)rays.size(), timer.stop());
+    for (size_t i = 0; i < 200; i++) {
+        const vvox::VoxelRay& ray = rays[i];
+        f64v3 d = ray.direction / glm::length(ray.direction);
+        bool found = false;
+        for (f64 t = 0.0; t < ray.maxDistance && !found; t += SAMPLE_STEP) {
+            f64v3 p = ray.origin + d * t;
+            i32v3 v(std::floor(p.x), std::floor(p.y), std::floor(p.z));
+            if (!isSolid(v)) continue;
+            found = true;
+            if (!hits[i].hit) return false;
+            if (hits[i].voxel != v && rayOverlap(ray, hits[i].voxel) > SAMPLE_STEP * 2) return false;
+        }
+        if (!found && hits[i].hit && rayOverlap(ray, hits[i].voxel) > SAMPLE_STEP * 2) return false;
+    }
+    return true;
+}
+
+namespace {
+    /// Maps a mod-pack-like mix of textures and checks that no tile is mapped twice
+    bool stitchTextures(vvox::VoxelTextureStitcher& stitcher, size_t count, f64& ms) {
+        const ui32 TILES_PER_ROW = stitcher.getTilesPerRow();
+        const ui32 TILES_PER_PAGE = stitcher.getTilesPerPage();
+        std::vector<bool> mapped(1, true);
+        auto claim = [&] (ui32 index) {
+            if (index >= mapped.size()) mapped.resize(index + 1, false);
+            if (mapped[index]) return false;
+            mapped[index] = true;
+            return true;
+        };
+
+        std::mt19937 rng(17);
+        PreciseTimer timer;
+        for (size_t t = 0; t < count; t++) {
+            ui32 kind = rng() % 10;
+            if (kind < 6) {
+                if (!claim(stitcher.mapSingle())) return false;
+            } else if (kind < 9) {
+                ui32 w = 1 + rng() % 3, h = 1 + rng() % 3;
+                ui32 index = stitcher.mapBox(w, h);
+                // Boxes stay inside a page row-wise
+                if ((index % TILES_PER_PAGE) % TILES_PER_ROW + w > TILES_PER_ROW) return false;
+                if ((index % TILES_PER_PAGE) / TILES_PER_ROW + h > TILES_PER_ROW) return false;
+                for (ui32 y = 0; y < h; y++) {
+                    for (ui32 x = 0; x < w; x++) {
+                        if (!claim(index + y * TILES_PER_ROW + x)) return false;
+                    }
+                }
+            } else {
+                ui32 n = 2 + rng() % 20;
+                ui32 index = stitcher.mapContiguous(n);
+                for (ui32 i = 0; i < n; i++) {
+                    if (!claim(index + i)) return false;
+                }
+            }
+        }
+        ms = timer.stop();
+
+        for (ui32 i = 0; i < mapped.size(); i++) {
+            if (mapped[i] != stitcher.isMapped(i)) return false;
+        }
+        return stitcher.getStats().usedTiles == (size_t)std::count(mapped.begin(), mapped.end(), true);
+    }
+}
+
+TEST(TextureStitcher) {
+    const size_t TEXTURES = 5000;
+    vvox::VoxelTextureStitcher stitcher(16);
+    f64 ms;
+    if (!stitchTextures(stitcher, TEXTURES, ms)) return false;
+    vvox::AtlasStats stats = stitcher.getStats();
+    printf("Packing of %u textures: %lf ms, %u pages, %.1f%% filled\n",
+           (ui32)TEXTURES, ms, (ui32)stats.pages, stats.fillRatio * 100.0f);
+    if (stats.pages != stitcher.getNumPages() || stats.totalTiles != stats.pages * stitcher.getTilesPerPage()) return false;
+
+    // The null texture is reserved
+    vvox::VoxelTextureStitcher small(4);
+    if (!small.isMapped(0) || small.mapSingle() != 1) return false;
+    // Runs may cross pages
+    ui32 run = small.mapContiguous(40);
+    return run == 2 && small.getNumPages() == 3 && small.isMapped(2 + 39) && !small.isMapped(2 + 40);
+}
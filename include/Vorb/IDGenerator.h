@@ -19,10 +19,15 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <vector>
+
 #include "Vorb/types.h"
 #endif // !VORB_USING_PCH
+#include <atomic>
 #include <queue>
 
+#include <Vorb/concurrentqueue.h>
+
 namespace vorb {
     namespace core {
 #define ID_GENERATOR_NULL_ID 0
@@ -69,6 +74,164 @@ namespace vorb {
             T m_currentID = ID_GENERATOR_NULL_ID; ///< Auto-incremented ID
             std::queue<T> m_recycled; ///< List of recycled IDs
         };
+
+        /// An index packed together with the generation of that index
+        /// @tparam T: Unsigned integer type holding both parts
+        /// @tparam IndexBits: Number of low bits used for the index, the rest holds the generation
+        template<typename T, size_t IndexBits>
+        struct GenerationalID {
+            static_assert(IndexBits > 0 && IndexBits < sizeof(T) * 8, "GenerationalID needs bits for both the index and the generation");
+            static const T INDEX_MASK = (T(1) << IndexBits) - 1; ///< Bits of the index
+            static const T GENERATION_MASK = T(~T(0)) >> IndexBits; ///< Bits of the generation, after shifting
+
+            GenerationalID() : value(ID_GENERATOR_NULL_ID) {};
+            GenerationalID(T index, T generation) : value(((generation & GENERATION_MASK) << IndexBits) | (index & INDEX_MASK)) {};
+
+            /// @return The index part
+            T getIndex() const {
+                return value & INDEX_MASK;
+            }
+            /// @return The generation part
+            T getGeneration() const {
+                return value >> IndexBits;
+            }
+
+            bool operator==(const GenerationalID& other) const {
+                return value == other.value;
+            }
+            bool operator!=(const GenerationalID& other) const {
+                return value != other.value;
+            }
+
+            T value; ///< Packed index and generation
+        };
+
+        /// Generates and recycles indices, handing out handles that become invalid once their index is recycled
+        /// Indices are reused in the same order as IDGenerator, but a stale handle never aliases the new owner.
+        /// @tparam T: Unsigned integer type of handles
+        /// @tparam IndexBits: Number of low bits used for the index
+        template<typename T, size_t IndexBits>
+        class GenerationalIDGenerator {
+        public:
+            typedef GenerationalID<T, IndexBits> Handle; ///< Handle type that is handed out
+
+            /// Grabs an unused index, either new or recycled
+            /// @param wasNew: Additional return value to determine if a new index was created
+            /// @return Handle to the index
+            Handle generate(OPT bool* wasNew = nullptr) {
+                T index;
+                if (m_recycled.size() > 0) {
+                    index = m_recycled.front();
+                    m_recycled.pop();
+                    if (wasNew) *wasNew = false;
+                } else {
+                    // Slot 0 stays unused so that a null handle is never valid
+                    if (m_slots.empty()) m_slots.emplace_back();
+                    index = (T)m_slots.size();
+                    m_slots.emplace_back();
+                    if (wasNew) *wasNew = true;
+                }
+                m_slots[index].alive = true;
+                return Handle(index, m_slots[index].generation);
+            }
+            /// Returns a handle's index to the recycle queue, invalidating all handles to it
+            /// @param h: Handle to release
+            /// @return False if the handle was already invalid
+            bool recycle(const Handle& h) {
+                if (!isValid(h)) return false;
+                Slot& slot = m_slots[h.getIndex()];
+                slot.alive = false;
+                slot.generation = (slot.generation + 1) & Handle::GENERATION_MASK;
+                m_recycled.push(h.getIndex());
+                return true;
+            }
+
+            /// Check that a handle still refers to a live index
+            /// @param h: Handle to check
+            /// @return True if the index has not been recycled since the handle was made
+            bool isValid(const Handle& h) const {
+                T index = h.getIndex();
+                if (index == ID_GENERATOR_NULL_ID || index >= m_slots.size()) return false;
+                const Slot& slot = m_slots[index];
+                return slot.alive && slot.generation == h.getGeneration();
+            }
+            /// Obtain the current handle of an index
+            /// @param index: A live index
+            /// @return Handle to the index
+            Handle getHandle(T index) const {
+                return Handle(index, m_slots[index].generation);
+            }
+
+            /// Reset this generator to a fresh state
+            void reset() {
+                std::vector<Slot>().swap(m_slots);
+                std::queue<T>().swap(m_recycled);
+            }
+
+            /// @return Number of active indices
+            size_t getActiveCount() const {
+                return (m_slots.empty() ? 0 : m_slots.size() - 1) - m_recycled.size();
+            }
+        private:
+            /// State of an index
+            struct Slot {
+                T generation = 0; ///< Generation of the current or next owner
+                bool alive = false; ///< True while the index is handed out
+            };
+
+            std::vector<Slot> m_slots; ///< State of every index ever generated
+            std::queue<T> m_recycled; ///< List of recycled indices
+        };
+
+        /// IDGenerator that may be used from several threads at once without locks
+        /// Recycled IDs come back through a lock-free queue, so their reuse order is only roughly FIFO.
+        /// @tparam T: Integer type that std::atomic supports
+        template<typename T>
+        class ConcurrentIDGenerator {
+        public:
+            ConcurrentIDGenerator() : m_currentID(ID_GENERATOR_NULL_ID) {};
+
+            /// Grabs an unique ID from either generation of recycling
+            /// @param wasNew: Additional return value to determine if a new ID was created
+            /// @return An unique ID
+            T generate(OPT bool* wasNew = nullptr) {
+                T v;
+                if (m_recycled.try_dequeue(v)) {
+                    if (wasNew) *wasNew = false;
+                    return v;
+                }
+                if (wasNew) *wasNew = true;
+                return m_currentID.fetch_add(1) + 1;
+            }
+            /// Reserves a block of new IDs that a thread may hand out on its own
+            /// @param n: Number of IDs
+            /// @return First ID of the block, the block is [first, first + n)
+            T reserveBlock(size_t n) {
+                return m_currentID.fetch_add((T)n) + 1;
+            }
+            /// Returns an ID to a recycle queue
+            /// @pre: ID value is not in the recycle queue already
+            /// @param v: ID to recycle
+            void recycle(const T& v) {
+                m_recycled.enqueue(v);
+            }
+
+            /// Reset this generator to a fresh state
+            /// @pre: No other thread is using this generator
+            void reset() {
+                m_currentID = ID_GENERATOR_NULL_ID;
+                T v;
+                while (m_recycled.try_dequeue(v));
+            }
+
+            /// @return Approximate number of active IDs
+            size_t getActiveCount() const {
+                return static_cast<size_t>(m_currentID.load()) - m_recycled.size_approx();
+            }
+        private:
+            std::atomic<T> m_currentID; ///< Auto-incremented ID
+            moodycamel::ConcurrentQueue<T> m_recycled; ///< List of recycled IDs
+        };
     }
 }
 namespace vcore = vorb::core;
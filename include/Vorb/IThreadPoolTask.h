@@ -22,8 +22,34 @@
 #include "Vorb/types.h"
 #endif // !VORB_USING_PCH
 
+#include <atomic>
+
 namespace vorb {
     namespace core {
+        /// Scheduling priority of a task, lower values are dequeued first
+        enum class TaskPriority : ui8 {
+            HIGHEST = 0,
+            HIGH = 1,
+            NORMAL = 2,
+            LOW = 3
+        };
+#define THREAD_POOL_PRIORITY_LEVELS 4
+
+        /// Shared flag that lets a group of queued tasks be dropped before they run
+        class TaskCancelToken {
+        public:
+            TaskCancelToken() : m_isCancelled(false) {}
+
+            /// Marks every task using this token as cancelled
+            void cancel() { m_isCancelled.store(true, std::memory_order_release); }
+            /// Allows the token to be reused for new tasks
+            void reset() { m_isCancelled.store(false, std::memory_order_release); }
+            /// @return True if tasks using this token should not run
+            bool isCancelled() const { return m_isCancelled.load(std::memory_order_acquire); }
+        private:
+            std::atomic<bool> m_isCancelled; ///< True once cancelled
+        };
+
 
         template<typename T>
         class IThreadPoolTask {
@@ -45,8 +71,13 @@ namespace vorb {
            
             /// Getters
             const i32& getTaskId() const { return m_taskId; }
+            /// @return True if this task's cancel token has been cancelled
+            bool isCancelled() const { return cancelToken && cancelToken->isCancelled(); }
 
             volatile bool isFinished = false;
+            volatile bool wasSkipped = false; ///< True if the pool dropped this task because it was cancelled or cleared
+            TaskCancelToken* cancelToken = nullptr; ///< Optional token checked by the pool before execute
+            TaskPriority priority = TaskPriority::NORMAL; ///< Bucket that the pool queues this task in
         protected:
             i32 m_taskId;
         };
@@ -0,0 +1,124 @@
+//
+// ParallelFor.h
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file ParallelFor.h
+ * @brief Data parallel loops over index ranges using a vcore::ThreadPool.
+ */
+
+#pragma once
+
+#ifndef Vorb_ParallelFor_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_ParallelFor_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include "Vorb/types.h"
+#endif // !VORB_USING_PCH
+
+#include <atomic>
+
+#include "Vorb/IThreadPoolTask.h"
+#include "Vorb/ThreadPool.h"
+
+#define PARALLEL_FOR_MAX_HELPERS 32 ///< Most pool workers that join a single loop
+
+namespace vorb {
+    namespace core {
+        /// Runs fn over [begin, end) split into chunks of at least grain indices.
+        /// The calling thread works on chunks too and returns as soon as every chunk is done, without waiting
+        /// for helper tasks that the pool has not started yet, so it is also safe to call from a pool task.
+        /// Chunks are claimed from a shared counter and shrink as the range runs out, so uneven work balances
+        /// itself. One job is allocated per call, nothing is allocated per chunk.
+        /// @tparam T: Worker data type of the pool
+        /// @tparam F: Callable as fn(size_t chunkBegin, size_t chunkEnd)
+        /// @param pool: Pool whose workers help with the loop
+        /// @param begin: First index
+        /// @param end: One past the last index
+        /// @param grain: Smallest number of indices handed out at once
+        /// @param fn: Loop body for a chunk of indices
+        template<typename T, typename F>
+        void parallelFor(ThreadPool<T>& pool, size_t begin, size_t end, size_t grain, F&& fn);
+
+        /// Reduces [begin, end) in parallel. Every participant folds its chunks into its own partial value,
+        /// and the calling thread combines the partials once all chunks are done.
+        /// The way chunks are split between threads is not deterministic, so combine should be associative
+        /// and commutative if identical results are needed between runs.
+        /// @tparam T: Worker data type of the pool
+        /// @tparam V: Value type
+        /// @tparam F: Callable as V fn(size_t chunkBegin, size_t chunkEnd)
+        /// @tparam C: Callable as V combine(const V&, const V&)
+        /// @param pool: Pool whose workers help with the reduction
+        /// @param begin: First index
+        /// @param end: One past the last index
+        /// @param grain: Smallest number of indices handed out at once
+        /// @param identity: Neutral value for combine
+        /// @param fn: Reduces a chunk of indices to a value
+        /// @param combine: Merges two values
+        /// @return Combined value of the whole range
+        template<typename T, typename V, typename F, typename C>
+        V parallelReduce(ThreadPool<T>& pool, size_t begin, size_t end, size_t grain, const V& identity, F&& fn, C&& combine);
+
+        namespace impl {
+            /// Shared state of one parallel loop, owned jointly by the caller and its helper tasks
+            /// Helpers that start after the caller returned find the range exhausted and only drop their reference.
+            template<typename T, typename V, typename F, typename C>
+            class ParallelJob {
+            public:
+                /// Task that lets a pool worker take chunks of the loop
+                class Helper : public IThreadPoolTask<T> {
+                public:
+                    virtual void execute(T* workerData VORB_UNUSED) override {
+                        job->run(partial);
+                    }
+                    virtual void cleanup() override {
+                        // Also called for helpers the pool dropped, so the job is always freed
+                        job->release();
+                    }
+
+                    ParallelJob* job = nullptr; ///< Loop being helped
+                    V partial; ///< This helper's share of the result
+                };
+
+                ParallelJob(size_t begin, size_t end, size_t grain, size_t helperCount, const V& identity, F& fn, C& combine);
+
+                /// Claims the next chunk of the range
+                /// @param b: Resulting chunk begin
+                /// @param e: Resulting chunk end
+                /// @return False once the whole range has been handed out
+                bool claim(size_t& b, size_t& e);
+                /// Processes chunks until the range is exhausted
+                /// @param acc: Partial value to fold the chunks into
+                void run(V& acc);
+                /// Drops one reference, the last one frees the job
+                void release();
+
+                Helper helpers[PARALLEL_FOR_MAX_HELPERS]; ///< Tasks given to the pool, only the first helperCount are used
+                size_t helperCount; ///< Number of helpers given to the pool
+                std::atomic<size_t> done; ///< Number of indices that have been processed
+                size_t count; ///< Total number of indices
+            private:
+                std::atomic<size_t> m_next; ///< Next index to hand out
+                size_t m_end; ///< One past the last index
+                size_t m_grain; ///< Smallest chunk
+                size_t m_participants; ///< Helpers plus the caller
+                std::atomic<size_t> m_refs; ///< Caller and helpers still referencing this job
+                F* m_fn; ///< Loop body, only called while the caller waits
+                C* m_combine; ///< Value combiner
+            };
+
+            struct ParallelEmpty {}; ///< Value type for loops that have nothing to reduce
+        }
+    }
+}
+namespace vcore = vorb::core;
+
+#include "ParallelFor.inl"
+
+#endif // !Vorb_ParallelFor_h__
@@ -0,0 +1,92 @@
+template<typename T, typename V, typename F, typename C>
+vcore::impl::ParallelJob<T, V, F, C>::ParallelJob(size_t begin, size_t end, size_t grain, size_t helperCount, const V& identity, F& fn, C& combine) :
+    helperCount(helperCount),
+    done(0),
+    count(end - begin),
+    m_next(begin),
+    m_end(end),
+    m_grain(grain),
+    m_participants(helperCount + 1),
+    m_refs(helperCount + 1),
+    m_fn(&fn),
+    m_combine(&combine) {
+    for (size_t i = 0; i < helperCount; i++) {
+        helpers[i].job = this;
+        helpers[i].partial = identity;
+        // The caller is waiting on these, so they go ahead of queued work
+        helpers[i].priority = TaskPriority::HIGHEST;
+    }
+}
+
+template<typename T, typename V, typename F, typename C>
+bool vcore::impl::ParallelJob<T, V, F, C>::claim(size_t& b, size_t& e) {
+    size_t cur = m_next.load(std::memory_order_relaxed);
+    while (cur < m_end) {
+        // Big chunks while there is plenty left, down to grain near the end to balance the tail
+        size_t remaining = m_end - cur;
+        size_t n = std::min(remaining, std::max(m_grain, remaining / (m_participants * 2)));
+        if (m_next.compare_exchange_weak(cur, cur + n, std::memory_order_relaxed)) {
+            b = cur;
+            e = cur + n;
+            return true;
+        }
+    }
+    return false;
+}
+
+template<typename T, typename V, typename F, typename C>
+void vcore::impl::ParallelJob<T, V, F, C>::run(V& acc) {
+    size_t b, e;
+    while (claim(b, e)) {
+        acc = (*m_combine)(acc, (*m_fn)(b, e));
+        done.fetch_add(e - b, std::memory_order_release);
+    }
+}
+
+template<typename T, typename V, typename F, typename C>
+void vcore::impl::ParallelJob<T, V, F, C>::release() {
+    if (m_refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete this;
+}
+
+template<typename T, typename V, typename F, typename C>
+V vcore::parallelReduce(ThreadPool<T>& pool, size_t begin, size_t end, size_t grain, const V& identity, F&& fn, C&& combine) {
+    if (begin >= end) return identity;
+    if (grain == 0) grain = 1;
+
+    // Only ask for as many helpers as there are spare chunks
+    size_t chunks = (end - begin + grain - 1) / grain;
+    size_t helperCount = std::min((size_t)std::max(pool.getNumWorkers(), 0), chunks - 1);
+    helperCount = std::min(helperCount, (size_t)PARALLEL_FOR_MAX_HELPERS);
+    if (helperCount == 0) return combine(identity, fn(begin, end));
+
+    typedef impl::ParallelJob<T, V, typename std::remove_reference<F>::type, typename std::remove_reference<C>::type> Job;
+    Job* job = new Job(begin, end, grain, helperCount, identity, fn, combine);
+
+    IThreadPoolTask<T>* tasks[PARALLEL_FOR_MAX_HELPERS];
+    for (size_t i = 0; i < helperCount; i++) tasks[i] = &job->helpers[i];
+    pool.addTasks(tasks, helperCount);
+
+    // Take part instead of blocking
+    V result = identity;
+    job->run(result);
+
+    // Everything is claimed, wait only for chunks still running on workers.
+    // Helpers that start after this find nothing left and only drop their reference.
+    while (job->done.load(std::memory_order_acquire) != job->count) std::this_thread::yield();
+
+    for (size_t i = 0; i < helperCount; i++) result = combine(result, job->helpers[i].partial);
+    job->release();
+    return result;
+}
+
+template<typename T, typename F>
+void vcore::parallelFor(ThreadPool<T>& pool, size_t begin, size_t end, size_t grain, F&& fn) {
+    auto body = [&] (size_t b, size_t e) {
+        fn(b, e);
+        return impl::ParallelEmpty();
+    };
+    auto combine = [] (const impl::ParallelEmpty&, const impl::ParallelEmpty&) {
+        return impl::ParallelEmpty();
+    };
+    parallelReduce(pool, begin, end, grain, impl::ParallelEmpty(), body, combine);
+}
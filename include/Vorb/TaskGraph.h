@@ -0,0 +1,138 @@
+//
+// TaskGraph.h
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file TaskGraph.h
+ * @brief Dependency graph of thread pool tasks that enqueues each task once its predecessors finish.
+ */
+
+#pragma once
+
+#ifndef Vorb_TaskGraph_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_TaskGraph_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <memory>
+#include <vector>
+
+#include "Vorb/types.h"
+#endif // !VORB_USING_PCH
+
+#include <atomic>
+
+#include "Vorb/IThreadPoolTask.h"
+#include "Vorb/ThreadPool.h"
+#include "Vorb/vorb_rpc.h"
+
+namespace vorb {
+    namespace core {
+        /// A set of tasks with ordering constraints between them
+        /// Tasks are not owned by the graph and run through the normal execute/cleanup cycle.
+        /// When a task finishes, the first successor it makes ready runs straight away on the
+        /// same worker so its inputs are still in cache, the other ready successors are added to the pool.
+        template<typename T>
+        class TaskGraph {
+        public:
+            typedef size_t NodeID; ///< Handle to a node in the graph
+
+            TaskGraph() : m_remaining(0) {};
+            ~TaskGraph() {};
+
+            /// Adds a task that runs on the thread pool
+            /// @param task: The task to run, must outlive the graph's execution
+            /// @return Handle of the new node
+            NodeID addTask(IThreadPoolTask<T>* task);
+            /// Adds a node that is handed to an RPCManager once its predecessors finish,
+            /// used to finish a chain of work on the thread that owns the RPCManager (ex. GL uploads)
+            /// @param manager: Manager that will process the request
+            /// @param rpc: Request with its function and user data already set
+            /// @return Handle of the new node
+            NodeID addRPC(RPCManager* manager, RPC* rpc);
+
+            /// Declares that a node may only start after another one has finished
+            /// @param before: Node that must finish first
+            /// @param after: Node that waits on before
+            void addDependency(NodeID before, NodeID after);
+
+            /// Starts executing the graph, every node without predecessors is enqueued
+            /// Each task's isFinished flag is reset, so it reflects only this submission.
+            /// @pre: The graph is not currently executing and contains no cycles
+            /// @param pool: Pool on which tasks will run
+            void submit(ThreadPool<T>* pool);
+
+            /// Removes all nodes
+            /// @pre: The graph is not currently executing
+            void clear();
+
+            /// @return True once every node of the last submission has finished or was skipped
+            /// Nodes dropped by the pool's clearTasks() or destroy() are skipped along with everything
+            /// that depends on them, their tasks are handed back with wasSkipped set.
+            bool isFinished() const { return m_remaining.load() == 0; }
+            /// @return Number of nodes in the graph
+            size_t getNodeCount() const { return m_nodes.size(); }
+        private:
+            VORB_NON_COPYABLE(TaskGraph);
+
+            /// Wrapper that runs a node's task and releases its successors
+            class Node : public IThreadPoolTask<T> {
+            public:
+                virtual void execute(T* workerData) override {
+                    graph->execute(this, workerData);
+                }
+                virtual void cleanup() override {
+                    // Only nodes the pool dropped without running are marked skipped
+                    if (this->wasSkipped) graph->skip(this);
+                    // The pool no longer touches this node after cleanup, so it is now safe to report it
+                    graph->m_remaining--;
+                }
+
+                /// Trampoline installed into an RPC node's request
+                void onRPC(Sender s, void* userData);
+
+                TaskGraph<T>* graph = nullptr; ///< Owning graph
+                IThreadPoolTask<T>* task = nullptr; ///< Task to execute, null for RPC nodes
+                RPCManager* rpcManager = nullptr; ///< Manager for RPC nodes
+                RPC* rpc = nullptr; ///< Request for RPC nodes
+                RPCFunction* rpcFunction = nullptr; ///< The request's own function, invoked by the trampoline
+                RPCFunction rpcTrampoline; ///< Delegate to onRPC
+
+                i32 predecessorCount = 0; ///< Number of nodes that must finish before this one
+                std::atomic<i32> predecessorsLeft; ///< Predecessors that have not yet finished
+                std::atomic<bool> isSkipped; ///< True once a predecessor was skipped, so this node must not run
+                std::vector<NodeID> successors; ///< Nodes that depend on this one
+            };
+
+            /// Runs a node and then any continuations it makes ready
+            void execute(Node* node, T* workerData);
+            /// Marks a node as finished and dispatches its successors
+            /// @param node: The finished node
+            /// @return A ready successor that the caller should run next, or nullptr
+            Node* release(Node* node);
+            /// Starts a node that has no more predecessors
+            void dispatch(Node* node);
+            /// Hands back a node's task without running it and skips every node that depends on it
+            /// @param node: Node that will not run, its own remaining count is left to the caller
+            void skip(Node* node);
+            /// Lets one of a node's predecessors be done with it
+            /// @param succ: Node whose predecessor finished or was skipped
+            /// @return True if succ is now ready to run, false if it waits on more predecessors or was skipped
+            bool releaseOne(Node* succ);
+
+            std::vector<std::unique_ptr<Node>> m_nodes; ///< All nodes, indexed by NodeID
+            ThreadPool<T>* m_pool = nullptr; ///< Pool of the current submission
+            std::atomic<size_t> m_remaining; ///< Nodes that have not finished in the current submission
+        };
+    }
+}
+namespace vcore = vorb::core;
+
+#include "TaskGraph.inl"
+
+#endif // !Vorb_TaskGraph_h__
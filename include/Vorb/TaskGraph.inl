@@ -0,0 +1,137 @@
+template<typename T>
+typename vcore::TaskGraph<T>::NodeID vcore::TaskGraph<T>::addTask(IThreadPoolTask<T>* task) {
+    Node* node = new Node;
+    node->graph = this;
+    node->task = task;
+    m_nodes.emplace_back(node);
+    return m_nodes.size() - 1;
+}
+
+template<typename T>
+typename vcore::TaskGraph<T>::NodeID vcore::TaskGraph<T>::addRPC(RPCManager* manager, RPC* rpc) {
+    Node* node = new Node;
+    node->graph = this;
+    node->rpcManager = manager;
+    node->rpc = rpc;
+    node->rpcTrampoline = makeDelegate(node, &Node::onRPC);
+    m_nodes.emplace_back(node);
+    return m_nodes.size() - 1;
+}
+
+template<typename T>
+void vcore::TaskGraph<T>::addDependency(NodeID before, NodeID after) {
+    m_nodes[before]->successors.push_back(after);
+    m_nodes[after]->predecessorCount++;
+}
+
+template<typename T>
+void vcore::TaskGraph<T>::submit(ThreadPool<T>* pool) {
+    m_pool = pool;
+    m_remaining = m_nodes.size();
+
+    // Reset all counts before anything can start running
+    for (auto& node : m_nodes) {
+        node->isFinished = false;
+        if (node->task) node->task->isFinished = false;
+        node->predecessorsLeft = node->predecessorCount;
+        node->isSkipped = false;
+    }
+    for (auto& node : m_nodes) {
+        if (node->predecessorCount == 0) dispatch(node.get());
+    }
+}
+
+template<typename T>
+void vcore::TaskGraph<T>::clear() {
+    std::vector<std::unique_ptr<Node>>().swap(m_nodes);
+    m_remaining = 0;
+}
+
+template<typename T>
+void vcore::TaskGraph<T>::dispatch(Node* node) {
+    if (node->rpc) {
+        // Swap in the trampoline so that successors are released once the RPC thread gets to it
+        node->rpcFunction = node->rpc->data.f;
+        node->rpc->data.f = &node->rpcTrampoline;
+        node->rpcManager->invoke(node->rpc, false);
+    } else {
+        node->priority = node->task->priority;
+        m_pool->addTask(node);
+    }
+}
+
+template<typename T>
+void vcore::TaskGraph<T>::execute(Node* node, T* workerData) {
+    Node* head = node;
+    while (node) {
+        // Same rules as plain tasks, including counting skipped ones
+        m_pool->runTask(node->task, workerData);
+
+        Node* next = release(node);
+
+        // The pool reports the head through cleanup, continuations are reported here
+        if (node != head) {
+            node->isFinished = true;
+            m_remaining--;
+        }
+        node = next;
+    }
+}
+
+template<typename T>
+typename vcore::TaskGraph<T>::Node* vcore::TaskGraph<T>::release(Node* node) {
+    Node* continuation = nullptr;
+    for (auto& id : node->successors) {
+        Node* succ = m_nodes[id].get();
+        if (!releaseOne(succ)) continue;
+
+        // Keep the first ready task on this worker
+        if (!continuation && !succ->rpc) {
+            continuation = succ;
+        } else {
+            dispatch(succ);
+        }
+    }
+    return continuation;
+}
+
+template<typename T>
+bool vcore::TaskGraph<T>::releaseOne(Node* succ) {
+    if (succ->predecessorsLeft.fetch_sub(1) != 1) return false;
+    if (!succ->isSkipped.load()) return true;
+
+    // The last predecessor skips it in place of running it
+    skip(succ);
+    succ->isFinished = true;
+    m_remaining--;
+    return false;
+}
+
+template<typename T>
+void vcore::TaskGraph<T>::skip(Node* node) {
+    if (node->task) {
+        node->task->wasSkipped = true;
+        node->task->isFinished = true;
+        node->task->cleanup();
+    }
+    for (auto& id : node->successors) {
+        Node* succ = m_nodes[id].get();
+        succ->isSkipped = true;
+        releaseOne(succ);
+    }
+}
+
+template<typename T>
+void vcore::TaskGraph<T>::Node::onRPC(Sender s, void* userData) {
+    // Restore the request so it can be reused
+    rpc->data.f = rpcFunction;
+    rpcFunction->invoke(s, userData);
+
+    for (auto& id : successors) {
+        Node* succ = graph->m_nodes[id].get();
+        if (graph->releaseOne(succ)) graph->dispatch(succ);
+    }
+
+    this->isFinished = true;
+    graph->m_remaining--;
+}
@@ -19,11 +19,15 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <deque>
+#include <mutex>
 #include <vector>
 
 #include "Vorb/types.h"
 #endif // !VORB_USING_PCH
 
+#include <algorithm>
+#include <atomic>
 #include <thread>
 #include <condition_variable>
 
@@ -43,50 +47,73 @@ enum class RenderTaskType;
 
 namespace vorb {
     namespace core {
+        template<typename T> class TaskGraph;
+
         template<typename T>
         class ThreadPool {
+            friend class TaskGraph<T>;
         public:
-            ThreadPool() {};
+            ThreadPool() : m_sleepingCount(0), m_skippedCount(0) {
+                for (auto& c : m_pendingCounts) c = 0;
+            };
             ~ThreadPool();
 
             /// Initializes the threadpool
             /// @param size: The number of worker threads
-            void init(ui32 size);
+            /// @param workStealing: If true, each worker keeps its own task deque and idle workers
+            /// steal from the others instead of all workers sharing a single queue
+            void init(ui32 size, bool workStealing = false);
 
             /// Frees all resources
             void destroy();
 
             /// Clears all unprocessed tasks from the task queue
+            /// Cleared tasks are handed back without running, like cancelled ones: wasSkipped and isFinished
+            /// are set and cleanup is called, so owners that free or count their tasks there still see them.
             void clearTasks();
 
             /// Adds a task to the task queue
+            /// Tasks are queued by their priority. In work stealing mode, tasks added from one of this
+            /// pool's workers stay on that worker's deque.
             /// @param task: The task to add
-            void addTask(IThreadPoolTask<T>* task) {
-                m_tasks.enqueue(task);
-            }
+            void addTask(IThreadPoolTask<T>* task);
 
             /// Add an array of tasks to the task queue
             /// @param tasks: The array of tasks to add
             /// @param size: The size of the array
-            void addTasks(IThreadPoolTask<T>* tasks[], size_t size) {
-                m_tasks.enqueue_bulk(tasks, size);
-            }
+            void addTasks(IThreadPoolTask<T>* tasks[], size_t size);
 
             /// Getters
             i32 getNumWorkers() const { return m_workers.size(); }
-            size_t getTasksSizeApprox() const { return m_tasks.size_approx(); }
+            size_t getTasksSizeApprox() const;
+            bool isWorkStealing() const { return m_isWorkStealing; }
+            /// @return Number of tasks dropped because their cancel token was set
+            size_t getSkippedTaskCount() const { return m_skippedCount.load(std::memory_order_relaxed); }
+            /// Restarts counting skipped tasks from zero
+            void resetSkippedTaskCount() { m_skippedCount = 0; }
         private:
             VORB_NON_COPYABLE(ThreadPool);
             // Typedef for func ptr
-            typedef void (ThreadPool<T>::*workerFunc)(T*);
+            typedef void (ThreadPool<T>::*workerFunc)(T*, size_t);
+            typedef moodycamel::ConcurrentQueue<IThreadPoolTask<T>*> TaskQueue;
+
+            /// Task deques owned by a single worker in work stealing mode
+            /// The owner pushes and pops at the back, thieves take from the front
+            struct WorkDeque {
+                ThreadPool<T>* owner; ///< Pool that this deque belongs to
+                std::mutex lock; ///< Guards tasks
+                std::deque<IThreadPoolTask<T>*> tasks[THREAD_POOL_PRIORITY_LEVELS]; ///< Tasks local to the worker, per priority
+                std::atomic<size_t> count { 0 }; ///< Total tasks in the deque, lets searches skip empty deques without locking
+            };
 
             /// Class definition for worker thread
             class WorkerThread {
             public:
                 /// Creates the thread
                 /// @param func: The function the thread should execute
-                WorkerThread(workerFunc func, ThreadPool<T>* threadPool) {
-                    thread = new std::thread(func, threadPool, &data);
+                /// @param index: Index of this worker in the pool
+                WorkerThread(workerFunc func, ThreadPool<T>* threadPool, size_t index) {
+                    thread = new std::thread(func, threadPool, &data, index);
                 }
 
                 /// Blocks until the worker thread completes
@@ -100,17 +127,47 @@ namespace vorb {
 
             /// Thread function that processes tasks
             /// @param data: The worker specific data
-            void workerThreadFunc(T* data);
+            /// @param index: Index of the worker, and of its deque in work stealing mode
+            void workerThreadFunc(T* data, size_t index);
+
+            /// Finds the next task for a worker, highest priority first. For each priority the order is
+            /// the worker's own deque, then the shared queue, then other workers' deques.
+            /// @param index: Index of the worker searching
+            /// @return A task, or nullptr if none could be found
+            IThreadPoolTask<T>* findTask(size_t index);
+            /// Runs a task on a worker, or skips it if it was cancelled
+            void runTask(IThreadPoolTask<T>* task, T* data);
+            /// Wakes sleeping workers after tasks were pushed
+            /// @param n: Number of tasks that were pushed
+            void signalTasks(size_t n);
+            /// @return Number of tasks pushed but not yet taken, over all priorities
+            i64 getPendingCount() const;
 
             /// Lock free task queues
-            moodycamel::BlockingConcurrentQueue<IThreadPoolTask<T>*> m_tasks; ///< Holds tasks to execute
+            TaskQueue m_tasks[THREAD_POOL_PRIORITY_LEVELS]; ///< Holds tasks to execute, per priority
            
             bool m_isInitialized = false; ///< true when the pool has been initialized
             std::vector<WorkerThread*> m_workers; ///< All the worker threads
+            std::atomic<i64> m_pendingCounts[THREAD_POOL_PRIORITY_LEVELS]; ///< Tasks pushed but not taken per priority (may briefly dip below zero)
+            std::atomic<size_t> m_sleepingCount; ///< Workers that are waiting for tasks
+            std::atomic<size_t> m_skippedCount; ///< Cancelled tasks that were not executed
+            std::mutex m_sleepLock; ///< Guards sleeping on m_sleepCond
+            std::condition_variable m_sleepCond; ///< Signaled when tasks are pushed
+
+            // Work stealing
+            bool m_isWorkStealing = false; ///< true when workers use their own deques
+            std::vector<WorkDeque*> m_deques; ///< Deque for each worker, indexed like m_workers
+
+            static thread_local WorkDeque* s_localDeque; ///< Deque of the worker running on this thread
         };
 
         template<typename T>
         class QuitThreadPoolTask : public IThreadPoolTask<T> {
+        public:
+            QuitThreadPoolTask() {
+                this->priority = TaskPriority::HIGHEST;
+            }
+        private:
             virtual void execute(T* workerData) override {
                 workerData->stop = true;
             }
@@ -1,3 +1,6 @@
+template<typename T>
+thread_local typename vcore::ThreadPool<T>::WorkDeque* vcore::ThreadPool<T>::s_localDeque = nullptr;
+
 template<typename T>
 vcore::ThreadPool<T>::~ThreadPool() {
     destroy();
@@ -6,21 +9,58 @@ vcore::ThreadPool<T>::~ThreadPool() {
 template<typename T>
 void vcore::ThreadPool<T>::clearTasks() {
     // Dequeue all tasks
+    std::vector<IThreadPoolTask<T>*> dropped;
     IThreadPoolTask<T>* task;
-    while (m_tasks.try_dequeue(task));
-    while (m_tasks.try_dequeue(task));
+    for (size_t p = 0; p < THREAD_POOL_PRIORITY_LEVELS; p++) {
+        i64 removed = 0;
+        while (m_tasks[p].try_dequeue(task)) {
+            dropped.push_back(task);
+            removed++;
+        }
+        m_pendingCounts[p] -= removed;
+    }
+
+    // Empty the worker deques
+    for (auto& dq : m_deques) {
+        std::lock_guard<std::mutex> l(dq->lock);
+        for (size_t p = 0; p < THREAD_POOL_PRIORITY_LEVELS; p++) {
+            m_pendingCounts[p] -= (i64)dq->tasks[p].size();
+            dropped.insert(dropped.end(), dq->tasks[p].begin(), dq->tasks[p].end());
+            dq->tasks[p].clear();
+        }
+        dq->count = 0;
+    }
+
+    // Hand them back outside of the locks, cleanup may queue more work
+    for (auto& t : dropped) {
+        t->wasSkipped = true;
+        t->isFinished = true;
+        t->cleanup();
+    }
 }
 
 template<typename T>
-void vcore::ThreadPool<T>::init(ui32 size) {
+void vcore::ThreadPool<T>::init(ui32 size, bool workStealing /*= false*/) {
     // Check if its already initialized
     if (m_isInitialized) return;
     m_isInitialized = true;
+    m_isWorkStealing = workStealing;
+    for (auto& c : m_pendingCounts) c = 0;
+    m_sleepingCount = 0;
+
+    // Deques must all exist before any worker can try to steal from them
+    if (m_isWorkStealing) {
+        m_deques.resize(size);
+        for (ui32 i = 0; i < size; i++) {
+            m_deques[i] = new WorkDeque;
+            m_deques[i]->owner = this;
+        }
+    }
 
     /// Allocate all threads
     m_workers.resize(size);
     for (ui32 i = 0; i < size; i++) {
-        m_workers[i] = new WorkerThread(&ThreadPool::workerThreadFunc, this);
+        m_workers[i] = new WorkerThread(&ThreadPool::workerThreadFunc, this, i);
     }
 }
 
@@ -29,8 +69,11 @@ void vcore::ThreadPool<T>::destroy() {
     if (!m_isInitialized) return;
 
     // Tell threads to quit
-    for (size_t i = 0; i < m_workers.size(); i++) {
-        m_workers[i]->data.stop = true;
+    {
+        std::lock_guard<std::mutex> l(m_sleepLock);
+        for (size_t i = 0; i < m_workers.size(); i++) {
+            m_workers[i]->data.stop = true;
+        }
     }
 
     clearTasks();
@@ -38,9 +81,14 @@ void vcore::ThreadPool<T>::destroy() {
     // Run quit tasks
     std::vector<QuitThreadPoolTask<T> > quitTasks(m_workers.size() * 2); // Extra tasks just in case
     for (size_t i = 0; i < quitTasks.size(); i++) {
-        m_tasks.enqueue(&quitTasks[i]);
+        m_tasks[(size_t)TaskPriority::HIGHEST].enqueue(&quitTasks[i]);
+    }
+    m_pendingCounts[(size_t)TaskPriority::HIGHEST] += (i64)quitTasks.size();
+    {
+        std::lock_guard<std::mutex> l(m_sleepLock);
+        m_sleepCond.notify_all();
     }
-    
+
     // Join all threads
     for (size_t i = 0; i < m_workers.size(); i++) {
         m_workers[i]->join();
@@ -51,23 +99,159 @@ void vcore::ThreadPool<T>::destroy() {
 
     // Free memory
     std::vector<WorkerThread*>().swap(m_workers);
+    for (auto& dq : m_deques) delete dq;
+    std::vector<WorkDeque*>().swap(m_deques);
 
     // We are no longer initialized
     m_isInitialized = false;
 }
 
 template<typename T>
-void vcore::ThreadPool<T>::workerThreadFunc(T* data) {
+void vcore::ThreadPool<T>::addTask(IThreadPoolTask<T>* task) {
+    size_t p = (size_t)task->priority;
+
+    // Tasks spawned by one of our workers stay with that worker
+    WorkDeque* dq = s_localDeque;
+    if (dq && dq->owner == this) {
+        std::lock_guard<std::mutex> l(dq->lock);
+        dq->tasks[p].push_back(task);
+        dq->count++;
+    } else {
+        m_tasks[p].enqueue(task);
+    }
+    m_pendingCounts[p]++;
+    signalTasks(1);
+}
+
+template<typename T>
+void vcore::ThreadPool<T>::addTasks(IThreadPoolTask<T>* tasks[], size_t size) {
+    WorkDeque* dq = s_localDeque;
+    if (dq && dq->owner == this) {
+        std::lock_guard<std::mutex> l(dq->lock);
+        for (size_t i = 0; i < size; i++) dq->tasks[(size_t)tasks[i]->priority].push_back(tasks[i]);
+        dq->count += size;
+        for (size_t i = 0; i < size; i++) m_pendingCounts[(size_t)tasks[i]->priority]++;
+    } else {
+        // Bulk enqueue runs of equal priority
+        size_t start = 0;
+        for (size_t i = 1; i <= size; i++) {
+            if (i == size || tasks[i]->priority != tasks[start]->priority) {
+                size_t p = (size_t)tasks[start]->priority;
+                m_tasks[p].enqueue_bulk(tasks + start, i - start);
+                m_pendingCounts[p] += (i64)(i - start);
+                start = i;
+            }
+        }
+    }
+    signalTasks(size);
+}
+
+template<typename T>
+size_t vcore::ThreadPool<T>::getTasksSizeApprox() const {
+    return (size_t)std::max<i64>(getPendingCount(), 0);
+}
+
+template<typename T>
+i64 vcore::ThreadPool<T>::getPendingCount() const {
+    i64 n = 0;
+    for (auto& c : m_pendingCounts) n += c.load(std::memory_order_relaxed);
+    return n;
+}
+
+template<typename T>
+void vcore::ThreadPool<T>::signalTasks(size_t n) {
+    // Only touch the lock when someone may be asleep
+    if (m_sleepingCount.load() > 0) {
+        std::lock_guard<std::mutex> l(m_sleepLock);
+        if (n == 1) {
+            m_sleepCond.notify_one();
+        } else {
+            m_sleepCond.notify_all();
+        }
+    }
+}
+
+template<typename T>
+vcore::IThreadPoolTask<T>* vcore::ThreadPool<T>::findTask(size_t index) {
+    IThreadPoolTask<T>* task = nullptr;
+
+    for (size_t p = 0; p < THREAD_POOL_PRIORITY_LEVELS; p++) {
+        // Skip priorities that have nothing queued
+        if (m_pendingCounts[p].load(std::memory_order_relaxed) <= 0) continue;
+
+        if (m_isWorkStealing && m_deques[index]->count.load(std::memory_order_relaxed) > 0) {
+            // Newest local task first, its data is most likely still in cache
+            WorkDeque* dq = m_deques[index];
+            std::lock_guard<std::mutex> l(dq->lock);
+            if (!dq->tasks[p].empty()) {
+                task = dq->tasks[p].back();
+                dq->tasks[p].pop_back();
+                dq->count--;
+                m_pendingCounts[p]--;
+                return task;
+            }
+        }
+
+        // Tasks from outside the pool
+        if (m_tasks[p].try_dequeue(task)) {
+            m_pendingCounts[p]--;
+            return task;
+        }
+
+        // Steal the oldest task from another worker
+        for (size_t i = 1; i < m_deques.size(); i++) {
+            WorkDeque* dq = m_deques[(index + i) % m_deques.size()];
+            if (dq->count.load(std::memory_order_relaxed) == 0) continue;
+            std::lock_guard<std::mutex> l(dq->lock);
+            if (!dq->tasks[p].empty()) {
+                task = dq->tasks[p].front();
+                dq->tasks[p].pop_front();
+                dq->count--;
+                m_pendingCounts[p]--;
+                return task;
+            }
+        }
+    }
+    return nullptr;
+}
+
+template<typename T>
+inline void vcore::ThreadPool<T>::runTask(IThreadPoolTask<T>* task, T* data) {
+    if (task->isCancelled()) {
+        // Dropped without running, but still handed back to its owner
+        task->wasSkipped = true;
+        m_skippedCount++;
+    } else {
+        task->wasSkipped = false;
+        task->execute(data);
+    }
+    task->isFinished = true;
+    task->cleanup();
+}
+
+template<typename T>
+void vcore::ThreadPool<T>::workerThreadFunc(T* data, size_t index) {
     data->stop = false;
-    IThreadPoolTask<T>* task;
+    if (m_isWorkStealing) s_localDeque = m_deques[index];
 
     while (true) {
         // Check for exit
-        if (data->stop) return;
+        if (data->stop) break;
 
-        m_tasks.wait_dequeue(task);
-        task->execute(data);
-        task->isFinished = true;
-        task->cleanup();
+        IThreadPoolTask<T>* task = findTask(index);
+        if (task) {
+            runTask(task, data);
+            continue;
+        }
+
+        // Sleep until more work shows up
+        m_sleepingCount++;
+        {
+            std::unique_lock<std::mutex> l(m_sleepLock);
+            m_sleepCond.wait(l, [&] { return getPendingCount() > 0 || data->stop; });
+        }
+        m_sleepingCount--;
     }
+
+    s_localDeque = nullptr;
 }
@@ -19,14 +19,62 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <vector>
+
 #include "../types.h"
 #endif // !VORB_USING_PCH
 
+#include <algorithm>
+#include <cstring>
+
+#if defined(VORB_ARCH_X86_64)
+#include <emmintrin.h>
+#endif
+#if defined(VORB_COMPILER_MSVC)
+#include <intrin.h>
+#endif
+
+#define BIT_TABLE_WORD_BITS 64
+#define BIT_TABLE_WORD_SHIFT 6
+#define BIT_TABLE_WORD_MASK 63
+
 namespace vorb {
     namespace ecs {
         class BitTable;
 
-        /// Convenience class for accessing an array of truth values
+        namespace impl {
+            /// @return Number of set bits in a word
+            inline ui32 popcount64(ui64 v) {
+#if defined(VORB_COMPILER_GCC) || defined(VORB_COMPILER_CLANG)
+                return (ui32)__builtin_popcountll(v);
+#else
+                v = v - ((v >> 1) & 0x5555555555555555ull);
+                v = (v & 0x3333333333333333ull) + ((v >> 2) & 0x3333333333333333ull);
+                v = (v + (v >> 4)) & 0x0F0F0F0F0F0F0F0Full;
+                return (ui32)((v * 0x0101010101010101ull) >> 56);
+#endif
+            }
+            /// @pre: v is not zero
+            /// @return Index of the lowest set bit of a word
+            inline ui32 lowestBit64(ui64 v) {
+#if defined(VORB_COMPILER_GCC) || defined(VORB_COMPILER_CLANG)
+                return (ui32)__builtin_ctzll(v);
+#elif defined(VORB_COMPILER_MSVC) && defined(VORB_ARCH_64)
+                unsigned long i;
+                _BitScanForward64(&i, v);
+                return (ui32)i;
+#else
+                ui32 i = 0;
+                while (!(v & 1)) {
+                    v >>= 1;
+                    i++;
+                }
+                return i;
+#endif
+            }
+        }
+
+        /// Convenience class for accessing a row of truth values
         class BitArray {
             friend class BitTable;
         public:
@@ -38,45 +86,49 @@ namespace vorb {
             /// Retrieve a bit value
             /// @param i: Index of value
             /// @return True if bit is non-zero
-            bool valueOf(const ui32& i) {
-                ui8& val = m_bits[i >> 3];
-                return ((val >> (i & 0x07)) & 0x01) == 1;
-            }
+            bool valueOf(const ui32& i) const;
 
             /// Set a bit true
             /// @param i: Index of value
-            void setTrue(const ui32& i) {
-                ui8& val = m_bits[i >> 3];
-                ui8 field = 0x01 << (i & 0x07);
-                val |= field;
-            }
+            void setTrue(const ui32& i);
             /// Set a bit false
             /// @param i: Index of value
-            void setFalse(const ui32& i) {
-                ui8& val = m_bits[i >> 3];
-                ui8 field = 0x01 << (i & 0x07);
-                val &= ~field;
-            }
+            void setFalse(const ui32& i);
             /// Toggle a bit's value
             /// @param i: Index of value
-            void toggleValue(const ui32& i) {
-                ui8& val = m_bits[i >> 3];
-                ui8 field = 0x01 << (i & 0x07);
-                val ^= field;
-            }
+            void toggleValue(const ui32& i);
+
+            /// @return Number of set bits
+            ui32 popcount() const;
+            /// Find the next set bit
+            /// @param i: Index from which to start searching
+            /// @return Index of the first set bit at or after i, or the table's column count if there is none
+            ui32 findNextSet(const ui32& i) const;
+            /// @param mask: Words to compare against, one per word of the row
+            /// @return True if every bit of the mask is set in this row
+            bool containsAll(const ui64* mask) const;
+            /// @param mask: Words to compare against, one per word of the row
+            /// @return True if no bit of the mask is set in this row
+            bool containsNone(const ui64* mask) const;
         private:
             /// Internal constructor
-            /// @param bits: Data
-            BitArray(ui8* bits) :
-                m_bits(bits) {
+            /// @param table: Owning table
+            /// @param row: Row index
+            BitArray(BitTable* table, ui32 row) :
+                m_table(table),
+                m_row(row) {
                 // Empty
             }
 
-            ui8* m_bits = nullptr; ///< Pointer to bits
+            BitTable* m_table = nullptr; ///< Owning table
+            ui32 m_row = 0; ///< Row index within the table
         };
 
-        /// Table of bits stored in row-major order
+        /// Table of bits stored in 64-bit words
+        /// Rows are stored row-major for per-row operations, and every column is mirrored as its own bit
+        /// vector so that queries over many rows work on whole words of rows at once.
         class BitTable {
+            friend class BitArray;
         public:
             /// @ return Rows in the table
             const ui32& getRowCount() const {
@@ -86,12 +138,16 @@ namespace vorb {
             const ui32& getBitColumnCount() const {
                 return m_columnsBits;
             }
+            /// @return Number of words in a row, which is the length of masks
+            const ui32& getRowWordCount() const {
+                return m_columns;
+            }
 
             /// Obtain a row's bit data
             /// @param r: Row from which to obtain values
-            /// @return Array pointer to the row (invalidates on this table's resizing operations)
+            /// @return Accessor to the row
             BitArray getRow(const ui32& r) {
-                return BitArray(&m_bits[r * m_columns]);
+                return BitArray(this, r);
             }
 
             /// Retrieve a bit value
@@ -99,85 +155,224 @@ namespace vorb {
             /// @param c: Column of value
             /// @return True if bit is non-zero
             bool valueOf(const ui32& r, const ui32& c) const {
-                const ui8* bits = &m_bits[r * m_columns];
-                bits += c >> 3;
-                return ((*bits >> (c & 0x07)) & 0x01) == 1;
+                return ((rowData(r)[c >> BIT_TABLE_WORD_SHIFT] >> (c & BIT_TABLE_WORD_MASK)) & 1) == 1;
             }
 
             /// Set a bit true
             /// @param r: Row of value
             /// @param c: Column of value
             void setTrue(const ui32& r, const ui32& c) {
-                ui8* val = &m_bits[r * m_columns];
-                val += c >> 3;
-                ui8 field = 0x01 << (c & 0x07);
-                *val |= field;
+                rowData(r)[c >> BIT_TABLE_WORD_SHIFT] |= 1ull << (c & BIT_TABLE_WORD_MASK);
+                columnData(c)[r >> BIT_TABLE_WORD_SHIFT] |= 1ull << (r & BIT_TABLE_WORD_MASK);
             }
             /// Set a bit false
             /// @param r: Row of value
             /// @param c: Column of value
             void setFalse(const ui32& r, const ui32& c) {
-                ui8* val = &m_bits[r * m_columns];
-                val += c >> 3;
-                ui8 field = 0x01 << (c & 0x07);
-                *val &= ~field;
+                rowData(r)[c >> BIT_TABLE_WORD_SHIFT] &= ~(1ull << (c & BIT_TABLE_WORD_MASK));
+                columnData(c)[r >> BIT_TABLE_WORD_SHIFT] &= ~(1ull << (r & BIT_TABLE_WORD_MASK));
             }
             /// Toggle a bit's value
             /// @param r: Row of value
             /// @param c: Column of value
             void toggleValue(const ui32& r, const ui32& c) {
-                ui8* val = &m_bits[r * m_columns];
-                val += c >> 3;
-                ui8 field = 0x01 << (c & 0x07);
-                *val ^= field;
+                rowData(r)[c >> BIT_TABLE_WORD_SHIFT] ^= 1ull << (c & BIT_TABLE_WORD_MASK);
+                columnData(c)[r >> BIT_TABLE_WORD_SHIFT] ^= 1ull << (r & BIT_TABLE_WORD_MASK);
             }
             /// Clear out an entire row
             /// @param r: Row
             void setRowFalse(const ui32& r) {
-                memset(m_bits.data() + r * m_columns, 0, m_columns);
+                ui64* row = rowData(r);
+                for (ui32 c = findNextSet(r, 0); c < m_columnsBits; c = findNextSet(r, c + 1)) {
+                    columnData(c)[r >> BIT_TABLE_WORD_SHIFT] &= ~(1ull << (r & BIT_TABLE_WORD_MASK));
+                }
+                memset(row, 0, m_columns * sizeof(ui64));
+            }
+
+            /// @param r: Row
+            /// @return Number of set bits in the row
+            ui32 popcount(const ui32& r) const {
+                const ui64* row = rowData(r);
+                ui32 n = 0;
+                for (ui32 w = 0; w < m_columns; w++) n += impl::popcount64(row[w]);
+                return n;
+            }
+            /// Find the next set bit of a row
+            /// @param r: Row
+            /// @param c: Column from which to start searching
+            /// @return Column of the first set bit at or after c, or getBitColumnCount() if there is none
+            ui32 findNextSet(const ui32& r, const ui32& c) const {
+                if (c >= m_columnsBits) return m_columnsBits;
+                const ui64* row = rowData(r);
+                ui32 w = c >> BIT_TABLE_WORD_SHIFT;
+                ui64 bits = row[w] & (~0ull << (c & BIT_TABLE_WORD_MASK));
+                while (!bits) {
+                    if (++w >= m_columns) return m_columnsBits;
+                    bits = row[w];
+                }
+                return (w << BIT_TABLE_WORD_SHIFT) + impl::lowestBit64(bits);
+            }
+            /// Set every bit of a mask in a row
+            /// @param r: Row
+            /// @param mask: One word per word of the row
+            void orRow(const ui32& r, const ui64* mask) {
+                applyRow(r, mask, [] (ui64 a, ui64 b) { return a | b; });
+            }
+            /// Clear every bit of a row that is not in a mask
+            /// @param r: Row
+            /// @param mask: One word per word of the row
+            void andRow(const ui32& r, const ui64* mask) {
+                applyRow(r, mask, [] (ui64 a, ui64 b) { return a & b; });
+            }
+
+            /// Find every row that has all of some columns set and all of other columns clear
+            /// Works on the column mirror, so one pass handles 64 rows per word (128 with SSE2).
+            /// @param all: Columns that must be set
+            /// @param allCount: Number of columns in all
+            /// @param none: Columns that must be clear
+            /// @param noneCount: Number of columns in none
+            /// @param rows: Output list to which matching rows are appended in increasing order
+            void queryRows(const ui32* all, size_t allCount, const ui32* none, size_t noneCount, std::vector<ui32>& rows) const {
+                size_t words = (m_rows + BIT_TABLE_WORD_MASK) >> BIT_TABLE_WORD_SHIFT;
+                size_t w = 0;
+#if defined(VORB_ARCH_X86_64)
+                for (; w + 2 <= words; w += 2) {
+                    __m128i acc = _mm_set1_epi32(-1);
+                    for (size_t i = 0; i < allCount; i++) {
+                        acc = _mm_and_si128(acc, _mm_loadu_si128((const __m128i*)(columnData(all[i]) + w)));
+                    }
+                    for (size_t i = 0; i < noneCount; i++) {
+                        acc = _mm_andnot_si128(_mm_loadu_si128((const __m128i*)(columnData(none[i]) + w)), acc);
+                    }
+                    // Skip blocks of 128 rows without matches
+                    if (_mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) == 0xFFFF) continue;
+                    ui64 out[2];
+                    _mm_storeu_si128((__m128i*)out, acc);
+                    emitRows(w, out[0], rows);
+                    emitRows(w + 1, out[1], rows);
+                }
+#endif
+                for (; w < words; w++) {
+                    ui64 acc = ~0ull;
+                    for (size_t i = 0; i < allCount; i++) acc &= columnData(all[i])[w];
+                    for (size_t i = 0; i < noneCount; i++) acc &= ~columnData(none[i])[w];
+                    emitRows(w, acc, rows);
+                }
             }
 
-            /// Add columns to the table (resizes every 8 new columns)
+            /// Add columns to the table (rows are only rewritten every 64 new columns)
             void addColumns(const size_t n) {
-                m_columnsBits += n;
-                ui32 col = (m_columnsBits + 7) >> 3;
+                m_columnsBits += (ui32)n;
+                ui32 col = (m_columnsBits + BIT_TABLE_WORD_MASK) >> BIT_TABLE_WORD_SHIFT;
                 if (col != m_columns) {
                     if (m_rows > 0) {
                         m_bits.resize(col * m_rows);
-                        ui32 diff = col - m_columns;
-
-                        ui8* oldData = &m_bits[m_rows * m_columns - 1];
-                        ui8* newData = &m_bits[m_rows * col - 1];     
 
-                        // Translate the data
+                        // Translate the data, back to front so no row is overwritten before it moves
                         for (ui32 r = m_rows; r > 0;) {
                             r--;
-                            for (ui32 c = 0; c < diff; c++) {
-                                *newData = 0;
-                                newData--;
-                            }
-                            for (ui32 c = 0; c < m_columns; c++) {
-                                *newData = *oldData;
-                                newData--;
-                                oldData--;
-                            }
+                            memmove(m_bits.data() + r * col, rowData(r), m_columns * sizeof(ui64));
+                            memset(m_bits.data() + r * col + m_columns, 0, (col - m_columns) * sizeof(ui64));
                         }
                     }
                     m_columns = col;
                 }
+                m_columnBits.resize(m_columnsBits * m_rowWords);
             }
             /// Add rows to the table
             void addRows(const size_t n) {
                 m_bits.resize(m_bits.size() + n * m_columns);
-                m_rows += n;
+                m_rows += (ui32)n;
+
+                // Columns have spare capacity so that they are not rewritten every 64 rows
+                ui32 needed = (m_rows + BIT_TABLE_WORD_MASK) >> BIT_TABLE_WORD_SHIFT;
+                if (needed > m_rowWords) {
+                    ui32 capacity = std::max(needed, m_rowWords * 2);
+                    std::vector<ui64> columns(m_columnsBits * capacity);
+                    for (ui32 c = 0; c < m_columnsBits; c++) {
+                        if (m_rowWords) memcpy(columns.data() + c * capacity, columnData(c), m_rowWords * sizeof(ui64));
+                    }
+                    m_columnBits.swap(columns);
+                    m_rowWords = capacity;
+                }
             }
 
         private:
+            ui64* rowData(const ui32& r) {
+                return m_bits.data() + r * m_columns;
+            }
+            const ui64* rowData(const ui32& r) const {
+                return m_bits.data() + r * m_columns;
+            }
+            ui64* columnData(const ui32& c) {
+                return m_columnBits.data() + c * m_rowWords;
+            }
+            const ui64* columnData(const ui32& c) const {
+                return m_columnBits.data() + c * m_rowWords;
+            }
+
+            /// Combine a row with a mask, keeping the column mirror in sync with the bits that changed
+            template<typename F>
+            void applyRow(const ui32& r, const ui64* mask, F op) {
+                ui64* row = rowData(r);
+                for (ui32 w = 0; w < m_columns; w++) {
+                    ui64 value = op(row[w], mask[w]);
+                    // Never set bits past the last column
+                    if (w == m_columns - 1 && (m_columnsBits & BIT_TABLE_WORD_MASK)) value &= (1ull << (m_columnsBits & BIT_TABLE_WORD_MASK)) - 1;
+                    for (ui64 changed = row[w] ^ value; changed; changed &= changed - 1) {
+                        ui32 c = (w << BIT_TABLE_WORD_SHIFT) + impl::lowestBit64(changed);
+                        columnData(c)[r >> BIT_TABLE_WORD_SHIFT] ^= 1ull << (r & BIT_TABLE_WORD_MASK);
+                    }
+                    row[w] = value;
+                }
+            }
+            /// Append the rows of a word of column results
+            void emitRows(size_t w, ui64 bits, std::vector<ui32>& rows) const {
+                // Bits past the last row are garbage when no column was required
+                if (((w + 1) << BIT_TABLE_WORD_SHIFT) > m_rows) bits &= (1ull << (m_rows & BIT_TABLE_WORD_MASK)) - 1;
+                for (; bits; bits &= bits - 1) rows.push_back((ui32)((w << BIT_TABLE_WORD_SHIFT) + impl::lowestBit64(bits)));
+            }
+
             ui32 m_columnsBits = 0; ///< Number of columns (bits per row)
-            ui32 m_columns = 0; ///< Number of columns (min. bytes per row)
+            ui32 m_columns = 0; ///< Number of columns (min. words per row)
             ui32 m_rows = 0; ///< Number of rows
-            std::vector<ui8> m_bits; ///< Data
+            ui32 m_rowWords = 0; ///< Words reserved for each column
+            std::vector<ui64> m_bits; ///< Row-major data
+            std::vector<ui64> m_columnBits; ///< Column-major copy of the data
         };
+
+        inline bool BitArray::valueOf(const ui32& i) const {
+            return m_table->valueOf(m_row, i);
+        }
+        inline void BitArray::setTrue(const ui32& i) {
+            m_table->setTrue(m_row, i);
+        }
+        inline void BitArray::setFalse(const ui32& i) {
+            m_table->setFalse(m_row, i);
+        }
+        inline void BitArray::toggleValue(const ui32& i) {
+            m_table->toggleValue(m_row, i);
+        }
+        inline ui32 BitArray::popcount() const {
+            return m_table->popcount(m_row);
+        }
+        inline ui32 BitArray::findNextSet(const ui32& i) const {
+            return m_table->findNextSet(m_row, i);
+        }
+        inline bool BitArray::containsAll(const ui64* mask) const {
+            const ui64* row = m_table->rowData(m_row);
+            for (ui32 w = 0; w < m_table->m_columns; w++) {
+                if ((row[w] & mask[w]) != mask[w]) return false;
+            }
+            return true;
+        }
+        inline bool BitArray::containsNone(const ui64* mask) const {
+            const ui64* row = m_table->rowData(m_row);
+            for (ui32 w = 0; w < m_table->m_columns; w++) {
+                if (row[w] & mask[w]) return false;
+            }
+            return true;
+        }
     }
 }
 namespace vecs = vorb::ecs;
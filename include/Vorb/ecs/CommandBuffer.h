@@ -0,0 +1,163 @@
+//
+// CommandBuffer.h
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file CommandBuffer.h
+ * @brief Records structural ECS changes off the main thread and plays them back at a sync point.
+ */
+
+#pragma once
+
+#ifndef Vorb_CommandBuffer_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_CommandBuffer_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <memory>
+#include <vector>
+
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include "Entity.h"
+#include "ComponentTable.hpp"
+
+/// Marks entity IDs that refer to an entity created by a command buffer
+#define COMMAND_BUFFER_PLACEHOLDER_BIT 0x80000000u
+
+namespace vorb {
+    namespace ecs {
+        class ECS;
+
+        /// List of deferred create, destroy, add-component and remove-component operations
+        /// A buffer is not synchronized, give each thread or job its own and play them back together
+        /// once the jobs are done. Nothing in the ECS is touched while recording.
+        class CommandBuffer {
+        public:
+            CommandBuffer() {};
+            ~CommandBuffer() {};
+
+            /// Set the sort key of commands recorded from now on
+            /// Playback orders commands by key, so keys that come from the work being done (ex. a job index)
+            /// give the same result no matter which thread recorded what.
+            /// @param key: Sort key
+            void setSortKey(ui32 key) {
+                m_sortKey = key;
+            }
+
+            /// Record the creation of an entity
+            /// @return Placeholder that may be used with this buffer's other commands
+            EntityID createEntity();
+            /// Record the destruction of an entity
+            /// @param eID: Entity or placeholder from this buffer
+            void destroyEntity(EntityID eID);
+            /// Record the addition of a default component
+            /// @param tableID: ID of the component table
+            /// @param eID: Entity or placeholder from this buffer
+            void addComponent(TableID tableID, EntityID eID);
+            /// Record the addition of a component with initial data
+            /// @param tableID: ID of the component table, which must be a ComponentTable<T>
+            /// @param eID: Entity or placeholder from this buffer
+            /// @param value: Data copied into the new component
+            template<typename T>
+            void addComponent(TableID tableID, EntityID eID, const T& value);
+            /// Record the removal of a component
+            /// @param tableID: ID of the component table
+            /// @param eID: Entity or placeholder from this buffer
+            void removeComponent(TableID tableID, EntityID eID);
+
+            /// Apply buffers to an ECS and clear them
+            /// All creations happen first, then component additions and removals, then all destructions.
+            /// Creations and component changes are ordered by sort key, equal keys keep buffer order followed
+            /// by recording order.
+            /// Entity batches fire ECS::onEntitiesAdded and ECS::onEntitiesRemoved once each.
+            /// @param ecs: Target system
+            /// @param buffers: Buffers to apply
+            /// @param n: Number of buffers
+            static void playback(ECS& ecs, CommandBuffer* const* buffers, size_t n);
+            /// Apply this buffer to an ECS and clear it
+            /// @param ecs: Target system
+            void playback(ECS& ecs) {
+                CommandBuffer* self = this;
+                playback(ecs, &self, 1);
+            }
+
+            /// Discard all recorded commands
+            void clear();
+
+            /// @return Number of recorded commands
+            size_t getCommandCount() const {
+                return m_createKeys.size() + m_commands.size() + m_destroyed.size();
+            }
+            /// @return Entities created by the last playback, indexed in creation order
+            const std::vector<EntityID>& getCreatedEntities() const {
+                return m_created;
+            }
+            /// Obtain the entity a placeholder turned into during the last playback
+            /// @param eID: Entity or placeholder from this buffer
+            /// @return Real entity ID
+            EntityID resolve(EntityID eID) const {
+                if (eID & COMMAND_BUFFER_PLACEHOLDER_BIT) return m_created[eID & ~COMMAND_BUFFER_PLACEHOLDER_BIT];
+                return eID;
+            }
+        private:
+            VORB_NON_COPYABLE(CommandBuffer);
+
+            /// Initial data for an added component
+            class Payload {
+            public:
+                virtual ~Payload() {};
+                /// Copy the data into a new component
+                virtual void apply(ComponentTableBase* table, ComponentID cID) = 0;
+            };
+            template<typename T>
+            class TypedPayload : public Payload {
+            public:
+                TypedPayload(const T& v) : value(v) {};
+                virtual void apply(ComponentTableBase* table, ComponentID cID) override {
+                    static_cast<ComponentTable<T>*>(table)->get(cID) = value;
+                }
+
+                T value; ///< Component data
+            };
+
+            enum class CommandType : ui8 {
+                ADD_COMPONENT,
+                REMOVE_COMPONENT
+            };
+            /// A recorded component change
+            struct Command {
+                ui32 sortKey; ///< Playback order
+                CommandType type; ///< Operation
+                TableID table; ///< Component table
+                EntityID entity; ///< Entity or placeholder
+                Payload* payload; ///< Initial data, or null
+            };
+
+            /// Add a component command
+            void record(CommandType type, TableID tableID, EntityID eID, Payload* payload);
+
+            ui32 m_sortKey = 0; ///< Sort key of new commands
+            std::vector<ui32> m_createKeys; ///< Sort key of each recorded creation
+            std::vector<Command> m_commands; ///< Recorded component changes
+            std::vector<EntityID> m_destroyed; ///< Recorded destructions
+            std::vector<std::unique_ptr<Payload>> m_payloads; ///< Owned initial data of commands
+            std::vector<EntityID> m_created; ///< Entities made by the last playback
+        };
+    }
+}
+namespace vecs = vorb::ecs;
+
+template<typename T>
+void vecs::CommandBuffer::addComponent(TableID tableID, EntityID eID, const T& value) {
+    m_payloads.emplace_back(new TypedPayload<T>(value));
+    record(CommandType::ADD_COMPONENT, tableID, eID, m_payloads.back().get());
+}
+
+#endif // !Vorb_CommandBuffer_h__
@@ -19,6 +19,7 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -38,10 +39,16 @@ namespace vorb {
 
             /// Constructor that requires a blank component for reference
             /// @param defaultData: Blank component data
-            ComponentTable(const T& defaultData) : ComponentTableBase() {
+            /// @param storage: How component IDs are assigned
+            ComponentTable(const T& defaultData, ComponentStorage storage = ComponentStorage::STABLE) : ComponentTableBase(storage) {
                 // Default data goes in the first slot
                 _components.emplace_back(ID_GENERATOR_NULL_ID, defaultData);
             }
+            /// Constructor that uses component constructor for defaults
+            /// @param storage: How component IDs are assigned
+            explicit ComponentTable(ComponentStorage storage) : ComponentTable(T(), storage) {
+                // Empty
+            }
             /// Default constructor that uses component constructor for defaults
             ComponentTable() : ComponentTable(T()) {
                 // Empty
@@ -77,6 +84,7 @@ namespace vorb {
                 return _components[0].second;
             }
 
+            /// Iteration visits every slot, with packed storage these are exactly the live components
             /// @return Iterator to the first pair of (entity ID, T)
             typename ComponentList::iterator begin() {
                 // + 1 to skip the default element
@@ -120,6 +128,14 @@ namespace vorb {
             virtual void disposeComponent(ComponentID cID VORB_UNUSED, EntityID eID VORB_UNUSED) override {
                 // Empty
             }
+            virtual void reserveComponents(size_t n) override {
+                size_t needed = _components.size() + n;
+                if (needed > _components.capacity()) _components.reserve(std::max(needed, _components.capacity() * 2));
+            }
+            virtual void moveComponent(ComponentID from, ComponentID to) override {
+                if (from != to) _components[to] = std::move(_components[from]);
+                _components.pop_back();
+            }
 
             ComponentList _components; ///< A list of (entity ID, Component)
         };
@@ -24,16 +24,24 @@
 
 #include "Entity.h"
 #include "ECS.h"
+#include "SparseIndex.hpp"
 #include "../Event.hpp"
 #include "../IDGenerator.h"
 
 namespace vorb {
     namespace ecs {
+        /// How a table assigns component IDs
+        enum class ComponentStorage {
+            STABLE, ///< Component IDs are recycled and never move, so they can be held on to
+            PACKED ///< Components stay contiguous, removing one moves the last component into its slot
+        };
+
         class ComponentTableBase {
             friend class ECS;
         public:
             /// Default constructor which sets up events
-            ComponentTableBase();
+            /// @param storage: How component IDs are assigned
+            ComponentTableBase(ComponentStorage storage = ComponentStorage::STABLE);
 
             /// @return This table's ID within an ECS
             const TableID& getID() const {
@@ -61,9 +69,14 @@ namespace vorb {
             /// @param eID: ID of entity to search
             /// @return Component ID if it exists, else ID_GENERATOR_NULL_ID
             ComponentID getComponentID(EntityID eID) const {
-                auto comp = _components.find(eID);
-                if (comp == _components.end()) return ID_GENERATOR_NULL_ID;
-                return comp->second;
+                ui32 i = m_entityIndex.get(eID);
+                if (i == 0) return ID_GENERATOR_NULL_ID;
+                return _components[i - 1].second;
+            }
+
+            /// @return How component IDs are assigned
+            const ComponentStorage& getStorage() const {
+                return m_storage;
             }
 
             /// @return Number of active components
@@ -71,7 +84,9 @@ namespace vorb {
                 return _components.size(); // This should be equal to _genComponent.getActiveCount()
             }
 
+            /// @throws std::runtime_error: With packed storage
             void unsafeSetSize(size_t n);
+            /// @throws std::runtime_error: With packed storage
             void unsafeSetLink(ECS& ecs, EntityID, ComponentID);
 
             Event<ComponentID, EntityID> onEntityAdded; ///< Called when an entity is added to this table
@@ -82,20 +97,35 @@ namespace vorb {
 
             virtual void initComponent(ComponentID cID, EntityID eID) = 0;
             virtual void disposeComponent(ComponentID cID, EntityID eID) = 0;
+
+            /// Make room for components that are about to be added
+            /// @param n: Number of additional components
+            virtual void reserveComponents(size_t n VORB_UNUSED) {
+                // Empty
+            }
+            /// Packed storage only: move the last component into a removed component's slot and free the last slot
+            /// @param from: ID of the last component
+            /// @param to: ID of the removed component, equal to from when the last component was removed
+            virtual void moveComponent(ComponentID from, ComponentID to) = 0;
         private:
             /// Registers a component for this entity
             /// @param eID: Entity ID
             /// @return Registered component ID
             /// @throws std::runtime_error: When an entity already has a registered component
             ComponentID add(EntityID eID);
+            /// Make room for a batch of components
+            /// @param n: Number of components about to be added
+            void reserve(size_t n);
             /// Removes an entity's component
             /// @param eID: Entity ID
             /// @return True if a component was removed
             bool remove(EntityID eID);
 
             TableID m_id; ///< ID within a system
-            ComponentBindingSet _components; ///< List of (entity ID, component ID) pairings
-            vcore::IDGenerator<ComponentID> _genComponent; ///< Unique ID generator
+            ComponentStorage m_storage; ///< How component IDs are assigned
+            ComponentBindingSet _components; ///< Packed list of (entity ID, component ID) pairings
+            SparseIndex m_entityIndex; ///< Position + 1 of each entity's pairing in _components
+            vcore::IDGenerator<ComponentID> _genComponent; ///< Unique ID generator for stable storage
         };
     }
 }
@@ -0,0 +1,198 @@
+//
+// ComponentView.hpp
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file ComponentView.hpp
+ * @brief Iteration over entities that hold a component in each of several tables.
+ */
+
+#pragma once
+
+#ifndef Vorb_ComponentView_hpp__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_ComponentView_hpp__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <tuple>
+
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include <algorithm>
+
+#include "ComponentTable.hpp"
+#include "../IndexSequence.hpp"
+#include "../ParallelFor.h"
+
+namespace vorb {
+    namespace ecs {
+        /// Joins several component tables on their entities
+        /// The table with the fewest components drives iteration in the order of its packed pairings.
+        /// The other tables are probed first at the same position in their own pairings, where entities
+        /// given their components together line up, and only through their sparse indices when that
+        /// misses. Nothing is cached between iterations, so a view never goes stale and may be kept
+        /// around or made on the fly.
+        template<typename... Ts>
+        class ComponentView {
+        public:
+            typedef std::tuple<EntityID, Ts&...> Row; ///< An entity with a reference to each of its components
+
+            /// @param tables: Tables whose components an entity must all have
+            ComponentView(ComponentTable<Ts>&... tables) :
+                m_tables(&tables...),
+                m_bases{ &tables... } {
+                // Empty
+            }
+
+            /// Walks the entities that match the view
+            class iterator {
+                friend class ComponentView;
+            public:
+                Row operator*() const {
+                    return m_view->makeRow(m_pos->first, m_ids, Indices());
+                }
+                iterator& operator++() {
+                    ++m_pos;
+                    ++m_index;
+                    settle();
+                    return *this;
+                }
+                bool operator==(const iterator& other) const {
+                    return m_pos == other.m_pos;
+                }
+                bool operator!=(const iterator& other) const {
+                    return m_pos != other.m_pos;
+                }
+            private:
+                iterator(ComponentView* view, size_t driver, ComponentBindingSet::const_iterator pos, ComponentBindingSet::const_iterator end, size_t index) :
+                    m_view(view),
+                    m_driver(driver),
+                    m_pos(pos),
+                    m_end(end),
+                    m_index(index) {
+                    settle();
+                }
+
+                /// Skips pairings whose entity is missing from another table
+                void settle() {
+                    while (m_pos != m_end && !m_view->resolve(*m_pos, m_index, m_driver, m_ids, Indices())) {
+                        ++m_pos;
+                        ++m_index;
+                    }
+                }
+
+                ComponentView* m_view; ///< View being iterated
+                size_t m_driver; ///< Index of the table that drives iteration
+                ComponentBindingSet::const_iterator m_pos; ///< Current pairing in the driving table
+                ComponentBindingSet::const_iterator m_end; ///< End of the driving table's pairings
+                size_t m_index; ///< Position of m_pos in the driving table's pairings
+                ComponentID m_ids[sizeof...(Ts)]; ///< Component IDs of the current entity
+            };
+
+            /// @return Iterator to the first matching entity
+            iterator begin() {
+                size_t driver = findDriver();
+                const ComponentTableBase& table = *m_bases[driver];
+                return iterator(this, driver, table.cbegin(), table.cend(), 0);
+            }
+            /// @return Iterator past the last matching entity
+            iterator end() {
+                size_t driver = findDriver();
+                const ComponentTableBase& table = *m_bases[driver];
+                return iterator(this, driver, table.cend(), table.cend(), table.getComponentCount());
+            }
+
+            /// Calls f for every matching entity
+            /// @param f: Callable as f(EntityID, Ts&...)
+            template<typename F>
+            void each(F&& f) {
+                size_t driver = findDriver();
+                ComponentBindingSet::const_iterator first = m_bases[driver]->cbegin();
+                size_t count = m_bases[driver]->getComponentCount();
+                for (size_t i = 0; i < count; i++) visit(first[i], i, driver, f, Indices());
+            }
+            /// Calls f for every matching entity, splitting the driving table's pairings across a pool
+            /// @pre: No components are added to or removed from the viewed tables until this returns
+            /// @param pool: Pool whose workers help with iteration
+            /// @param grain: Smallest number of pairings handed to a thread at once
+            /// @param f: Callable as f(EntityID, Ts&...), may run concurrently for different entities
+            template<typename T, typename F>
+            void parallelEach(vcore::ThreadPool<T>& pool, size_t grain, F&& f) {
+                size_t driver = findDriver();
+                ComponentBindingSet::const_iterator first = m_bases[driver]->cbegin();
+                vcore::parallelFor(pool, 0, m_bases[driver]->getComponentCount(), grain, [&] (size_t b, size_t e) {
+                    for (size_t i = b; i < e; i++) visit(first[i], i, driver, f, Indices());
+                });
+            }
+        private:
+            typedef make_index_sequence<sizeof...(Ts)> Indices;
+
+            /// @return Index of the table with the fewest components
+            size_t findDriver() const {
+                size_t driver = 0;
+                for (size_t i = 1; i < sizeof...(Ts); i++) {
+                    if (m_bases[i]->getComponentCount() < m_bases[driver]->getComponentCount()) driver = i;
+                }
+                return driver;
+            }
+
+            /// Finds an entity's component in another table
+            /// Entities that were given their components together sit at the same position in each table's
+            /// pairings, so that position is checked before falling back to the sparse index. This keeps
+            /// iteration sequential in every table instead of jumping through each index.
+            /// @param table: Index of the table to probe
+            /// @param eID: Entity to find
+            /// @param index: Position of the entity in the driving table's pairings
+            /// @return Component ID, or ID_GENERATOR_NULL_ID if the entity has no component in the table
+            ComponentID probe(size_t table, EntityID eID, size_t index) const {
+                const ComponentTableBase* base = m_bases[table];
+                if (index < base->getComponentCount()) {
+                    const ComponentBinding& binding = base->cbegin()[index];
+                    if (binding.first == eID) return binding.second;
+                }
+                return base->getComponentID(eID);
+            }
+            /// Looks up an entity's component in every table, stopping at the first one it lacks
+            /// @param binding: Pairing from the driving table
+            /// @param index: Position of the pairing in the driving table
+            /// @return True if the entity has all components
+            template<size_t... Is>
+            bool resolve(const ComponentBinding& binding, size_t index, size_t driver, ComponentID* ids, index_sequence<Is...>) const {
+                // Braced initializers are evaluated in order, so probing stops once one misses
+                bool found = true;
+                int expand[] = { (found = found && (ids[Is] = (Is == driver) ? binding.second : probe(Is, binding.first, index)) != ID_GENERATOR_NULL_ID, 0)... };
+                (void)expand;
+                return found;
+            }
+            template<size_t... Is>
+            Row makeRow(EntityID eID, const ComponentID* ids, index_sequence<Is...>) {
+                return Row(eID, std::get<Is>(m_tables)->get(ids[Is])...);
+            }
+            template<typename F, size_t... Is>
+            void visit(const ComponentBinding& binding, size_t index, size_t driver, F& f, index_sequence<Is...> indices) {
+                ComponentID ids[sizeof...(Ts)];
+                if (resolve(binding, index, driver, ids, indices)) f(binding.first, std::get<Is>(m_tables)->get(ids[Is])...);
+            }
+
+            std::tuple<ComponentTable<Ts>*...> m_tables; ///< Typed tables, used to fetch components
+            const ComponentTableBase* m_bases[sizeof...(Ts)]; ///< The same tables, used for runtime lookups
+        };
+
+        /// Creates a view over several tables
+        /// @param tables: Tables whose components an entity must all have
+        /// @return View that joins the tables
+        template<typename... Ts>
+        ComponentView<Ts...> makeView(ComponentTable<Ts>&... tables) {
+            return ComponentView<Ts...>(tables...);
+        }
+    }
+}
+namespace vecs = vorb::ecs;
+
+#endif // !Vorb_ComponentView_hpp__
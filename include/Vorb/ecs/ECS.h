@@ -37,6 +37,7 @@ namespace vorb {
         typedef std::pair<nString, ComponentTableBase*> NamedComponent; ///< A component table paired with its name
         typedef std::unordered_map<nString, TableID> ComponentSet; ///< Mapping of names to component table IDs
         typedef std::vector<ComponentTableBase*> ComponentList;
+        typedef vcore::GenerationalID<ui64, 32> EntityHandle; ///< Entity ID paired with a generation, invalid once the entity is deleted
 
         /// Entity Component System
         class ECS {
@@ -53,6 +54,18 @@ namespace vorb {
             size_t getActiveEntityCount() const {
                 return m_genEntity.getActiveCount();
             }
+            /// Obtain a handle that stops being alive once the entity is deleted, even if its ID is reused
+            /// @param id: A live entity
+            /// @return Handle to the entity
+            EntityHandle getHandle(EntityID id) const {
+                return m_genEntity.getHandle(id);
+            }
+            /// Check that a handle's entity has not been deleted
+            /// @param handle: Handle from getHandle
+            /// @return True if the entity is still alive
+            bool isAlive(const EntityHandle& handle) const {
+                return m_genEntity.isValid(handle);
+            }
             /// @return The dictionary of NamedComponents
             const ComponentSet& getComponents() const {
                 return m_components;
@@ -70,17 +83,42 @@ namespace vorb {
             void genEntities(const size_t& n, EntityID* ids) {
                 for (size_t i = 0; i < n; i++) ids[i] = addEntity();
             }
+            /// Generate a chunk of entities in one step
+            /// Storage grows once for the whole batch and onEntitiesAdded fires once instead of onEntityAdded per entity.
+            /// @param n: Number of entities to generate
+            /// @param ids: Pointer to output array of n entities
+            void addEntities(size_t n, EntityID* ids);
+            /// Delete a chunk of entities in one step
+            /// onEntitiesRemoved fires once with the entities that existed, instead of onEntityRemoved per entity.
+            /// @param ids: Entities to delete
+            /// @param n: Number of entities
+            /// @return Number of entities that were deleted
+            size_t deleteEntities(const EntityID* ids, size_t n);
 
             /// Add a component to an entity
             /// @param name: Friendly name of component
             /// @param id: Component owner entity
             /// @return ID of generated component
             ComponentID addComponent(nString name, EntityID id);
+            /// Add a component to a chunk of entities
+            /// Entities that already hold the component are skipped. Storage grows once for the whole batch
+            /// and onComponentsAdded fires once with the entities that received the component.
+            /// @param tableID: ID of the component table
+            /// @param ids: Component owner entities
+            /// @param n: Number of entities
+            /// @param cIDs: Optional output array of n generated component IDs, ID_GENERATOR_NULL_ID where skipped
+            /// @return Number of components that were added
+            size_t addComponents(TableID tableID, const EntityID* ids, size_t n, OPT ComponentID* cIDs = nullptr);
             /// Remove a component from an entity
             /// @param name: Friendly name of component
             /// @param id: Component owner entity
             /// @return True if a component was deleted
             bool deleteComponent(nString name, EntityID id);
+            /// Remove a component from an entity
+            /// @param tableID: ID of the component table
+            /// @param id: Component owner entity
+            /// @return True if a component was deleted
+            bool deleteComponent(TableID tableID, EntityID id);
             /// Check if an entity has a component
             /// @param tableID: ID of the component table
             /// @param id: Entity
@@ -92,6 +130,12 @@ namespace vorb {
             /// @return True if the entity holds that component
             bool hasComponent(const nString& name, const EntityID& id) const;
 
+            /// Find entities by the components they hold, without touching the component tables
+            /// @param all: Tables in which an entity must have a component
+            /// @param none: Tables in which an entity must not have a component
+            /// @param entities: Output list to which matching entities are appended in increasing order
+            void queryEntities(const std::vector<TableID>& all, const std::vector<TableID>& none, std::vector<EntityID>& entities) const;
+
             /// Add a component table to be referenced by a special name
             /// @param name: Friendly name of component table
             /// @param table: Component table
@@ -111,16 +155,23 @@ namespace vorb {
 
             Event<EntityID> onEntityAdded; ///< Called when an entity is added to this system
             Event<EntityID> onEntityRemoved; ///< Called when an entity is removed from this system
+            Event<const EntityID*, size_t> onEntitiesAdded; ///< Called once when a batch of entities is added to this system
+            Event<const EntityID*, size_t> onEntitiesRemoved; ///< Called once when a batch of entities is removed from this system
             Event<NamedComponent> onComponentAdded; ///< Called when a component table is added to this system
+            Event<TableID, const EntityID*, size_t> onComponentsAdded; ///< Called once when a component is added to a batch of entities
         private:
             typedef std::pair<ComponentTableBase*, std::shared_ptr<Delegate<void, Sender, EntityID>>> ComponentSubscriber;
             typedef std::unordered_map<nString, ComponentSubscriber> ComponentSubscriberSet;
 
             EntitySet m_entities; ///< List of entities
+            /// Make room for an entity in the bit table
+            /// @param id: A newly generated entity
+            void prepareRow(EntityID id);
+
             EntityID m_eidHighest = 0; ///< Highest generated entity ID
             BitTable m_entityComponents; ///< Truth table for components that an entity holds
 
-            vcore::IDGenerator<EntityID> m_genEntity; ///< Unique ID generator for entities
+            vcore::GenerationalIDGenerator<ui64, 32> m_genEntity; ///< Unique ID generator for entities
             ComponentSet m_components; ///< List of component tables
             ComponentList m_componentList; ///< Component tables organized by their id
         };
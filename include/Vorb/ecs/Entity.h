@@ -21,6 +21,7 @@
 #ifndef VORB_USING_PCH
 #include <unordered_set>
 #include <unordered_map>
+#include <vector>
 
 #include "../types.h"
 #endif // !VORB_USING_PCH
@@ -31,7 +32,7 @@ namespace vorb {
         typedef ui32 ComponentID; ///< Numeric ID type for components
         typedef ui32 TableID; ///< Numeric ID type for component tables
         typedef std::pair<EntityID, ComponentID> ComponentBinding;  ///< Pairing of entities and components
-        typedef std::unordered_map<EntityID, ComponentID> ComponentBindingSet; ///< Set of entity-component pairings
+        typedef std::vector<ComponentBinding> ComponentBindingSet; ///< Packed list of entity-component pairings
 
         /// Basically an ID in an ECS
         class Entity {
@@ -20,16 +20,22 @@
 
 #ifndef VORB_USING_PCH
 #include <memory>
-#include <unordered_map>
+#include <vector>
 
 #include "../types.h"
 #endif // !VORB_USING_PCH
 
+#include <stdexcept>
+
+#include "ComponentTableBase.h"
 #include "MultipleComponentSet.h"
+#include "SparseIndex.hpp"
 
 namespace vorb {
     namespace ecs {
         /// Tracks entities in specified component sets as well as their component IDs
+        /// Component IDs of tables with packed storage move on removal, so only stable tables can be tracked.
+        /// ComponentView handles packed tables.
         template<size_t N> 
         class MultiComponentTracker : public MultipleComponentSet {
         public:
@@ -60,29 +66,54 @@ namespace vorb {
 
             /// Default constructor that initializes hooks into itself
             MultiComponentTracker() : MultipleComponentSet() {
-                _fEntityAdded.reset(new Delegate<void, Sender, EntityID>(std::move(makeFunctor([&] (Sender sender, EntityID id) {
-                    Components comp;
+                _fEntityAdded.reset(new Delegate<void, Sender, EntityID>(std::move(makeFunctor([&] (Sender sender VORB_UNUSED, EntityID id) {
+                    std::pair<EntityID, Components> tracked;
+                    tracked.first = id;
                     for (size_t i = 0; i < N; i++) {
-                        comp.set(i, _tables[i]->getComponentID(id));
+                        tracked.second.set(i, _tables[i]->getComponentID(id));
                     }
-                    _trackedComponents.insert(std::make_pair(id, comp));
+                    _trackedComponents.push_back(tracked);
+                    _trackedIndex.set(id, (ui32)_trackedComponents.size());
                 }))));
-                onEntityAdded += _fEntityAdded.get();
+                onEntityAdded += *_fEntityAdded;
                 
-                _fEntityRemoved.reset(new Delegate<void, Sender, EntityID>(std::move(makeFunctor([&] (Sender sender, EntityID id) {
-                    _trackedComponents.erase(id);
+                _fEntityRemoved.reset(new Delegate<void, Sender, EntityID>(std::move(makeFunctor([&] (Sender sender VORB_UNUSED, EntityID id) {
+                    ui32 i = _trackedIndex.get(id);
+                    if (i == 0) return;
+
+                    // Fill the hole with the last entry
+                    if (i != _trackedComponents.size()) {
+                        _trackedComponents[i - 1] = _trackedComponents.back();
+                        _trackedIndex.set(_trackedComponents[i - 1].first, i);
+                    }
+                    _trackedComponents.pop_back();
+                    _trackedIndex.set(id, 0);
                 }))));
-                onEntityRemoved += _fEntityRemoved.get();
+                onEntityRemoved += *_fEntityRemoved;
+            }
+
+            /// Add another component type that all entities in this set must have
+            /// @param component: Additional component for criteria testing, with stable storage
+            /// @throws std::runtime_error: With packed storage, whose cached component IDs would go stale
+            virtual void addRequirement(ComponentTableBase* component) override {
+                if (component->getStorage() == ComponentStorage::PACKED) {
+                    throw std::runtime_error("Packed component tables cannot be tracked");
+                }
+                MultipleComponentSet::addRequirement(component);
             }
 
             /// Obtain the tracked components for an entity
             /// @param id: Tracked entity
             /// @return A list of tracked component ids
+            /// @throws std::out_of_range: When the entity is not tracked
             const Components& getComponents(const EntityID& id) const {
-                return _trackedComponents.at(id);
+                ui32 i = _trackedIndex.get(id);
+                if (i == 0) throw std::out_of_range("Entity is not tracked");
+                return _trackedComponents[i - 1].second;
             }
         private:
-            std::unordered_map<EntityID, Components> _trackedComponents; ///< Stores tracked component IDs for each entity
+            std::vector<std::pair<EntityID, Components>> _trackedComponents; ///< Packed component IDs of each tracked entity
+            SparseIndex _trackedIndex; ///< Position + 1 of each entity in _trackedComponents
             std::shared_ptr<Delegate<void, Sender, EntityID>> _fEntityAdded; ///< onEntityAdded listener
             std::shared_ptr<Delegate<void, Sender, EntityID>> _fEntityRemoved; ///< onEntityRemoved listener
         };
@@ -38,12 +38,12 @@ namespace vorb {
             /// Default constructor which initializes events
             MultipleComponentSet();
             /// Deletes hooks to registered tables
-            ~MultipleComponentSet();
+            virtual ~MultipleComponentSet();
 
             
             /// Add another component type that all entities in this set must have
             /// @param component: Additional component for criteria testing
-            void addRequirement(ComponentTableBase* component);
+            virtual void addRequirement(ComponentTableBase* component);
 
             /// @return Iterator to the first entity ID
             EntityIDSet::iterator begin() {
@@ -0,0 +1,69 @@
+//
+// SparseIndex.hpp
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file SparseIndex.hpp
+ * @brief Paged array that maps entity IDs to dense indices without hashing.
+ */
+
+#pragma once
+
+#ifndef Vorb_SparseIndex_hpp__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_SparseIndex_hpp__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <memory>
+#include <vector>
+
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include "Entity.h"
+
+#define SPARSE_INDEX_PAGE_BITS 12
+#define SPARSE_INDEX_PAGE_SIZE (1 << SPARSE_INDEX_PAGE_BITS)
+#define SPARSE_INDEX_PAGE_MASK (SPARSE_INDEX_PAGE_SIZE - 1)
+
+namespace vorb {
+    namespace ecs {
+        /// Maps entity IDs to values, where 0 means that the entity has no entry
+        /// Pages are only allocated for ranges of IDs that are used, so memory follows the live ID range.
+        class SparseIndex {
+        public:
+            /// Retrieve the value of an entity
+            /// @param eID: Entity ID
+            /// @return Stored value, or 0 if there is none
+            ui32 get(const EntityID& eID) const {
+                size_t page = eID >> SPARSE_INDEX_PAGE_BITS;
+                if (page >= m_pages.size() || !m_pages[page]) return 0;
+                return m_pages[page][eID & SPARSE_INDEX_PAGE_MASK];
+            }
+            /// Store the value of an entity, allocating its page when needed
+            /// @param eID: Entity ID
+            /// @param v: Value, 0 to clear the entry
+            void set(const EntityID& eID, ui32 v) {
+                size_t page = eID >> SPARSE_INDEX_PAGE_BITS;
+                if (page >= m_pages.size()) m_pages.resize(page + 1);
+                if (!m_pages[page]) m_pages[page].reset(new ui32[SPARSE_INDEX_PAGE_SIZE]());
+                m_pages[page][eID & SPARSE_INDEX_PAGE_MASK] = v;
+            }
+
+            /// Free all pages
+            void clear() {
+                std::vector<std::unique_ptr<ui32[]>>().swap(m_pages);
+            }
+        private:
+            std::vector<std::unique_ptr<ui32[]>> m_pages; ///< Pages of values, null where no entity was ever stored
+        };
+    }
+}
+namespace vecs = vorb::ecs;
+
+#endif // !Vorb_SparseIndex_hpp__
@@ -19,6 +19,9 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <iosfwd>
+#include <vector>
+
 #include "../types.h"
 #endif // !VORB_USING_PCH
 
@@ -50,7 +53,11 @@ namespace keg {
         // A Bad Value Was Given In The Data
         BAD_VALUE,
         // Not Enough Information Provided In The Data
-        EARLY_EOF
+        EARLY_EOF,
+        // Binary Data Was Written With A Different Layout Of The Type
+        SCHEMA_MISMATCH,
+        // A File Could Not Be Opened
+        FILE_NOT_FOUND
     };
 
     struct ReadContext {
@@ -69,11 +76,31 @@ namespace keg {
     Error parse(ui8* dest, keg::Node& data, ReadContext& context, Type* type);
     void evalData(ui8* dest, const Value* decl, keg::Node& node, ReadContext& context);
 
+    class TypePlan;
+
+    // Parse YAML As It Is Read Instead Of Loading The Whole Document First. Unknown Keys Are Skipped Without
+    // Being Stored, And A __TYPE__ Field Is Only Used When It Is The First Key Of Its Map. A Plan Compiled For
+    // The Type Finds Keys And Nested Types Through Its Tables, And Is Ignored When Compiled For Another Type
+    Error parseStream(void* dest, std::istream& data, Type* type, Environment* env = nullptr, const TypePlan* plan = nullptr);
+    Error parseStream(void* dest, std::istream& data, const nString& typeName, Environment* env = nullptr, const TypePlan* plan = nullptr);
+    Error parseStream(void* dest, const cString data, Type* type, Environment* env = nullptr, const TypePlan* plan = nullptr);
+    Error parseStream(void* dest, const cString data, const nString& typeName, Environment* env = nullptr, const TypePlan* plan = nullptr);
+
     nString write(const void* src, Type* type, Environment* env = nullptr);
     nString write(const void* src, const nString& typeName, Environment* env = nullptr);
     nString write(const void* src, const ui32& typeID, Environment* env = nullptr);
     bool write(const ui8* src, keg::YAMLWriter& e, Environment* env, Type* type);
 
+#define KEG_BINARY_VERSION 1
+    // Hash Of Everything About A Type That Affects Its Binary Form, Including Nested Types And Enums
+    ui64 getSchemaHash(Type* type, Environment* env = nullptr);
+    // Append Data In Binary Form, Tagged With The Type's Schema Hash, To A Buffer
+    bool writeBinary(std::vector<ui8>& out, const void* src, Type* type, Environment* env = nullptr);
+    bool writeBinary(std::vector<ui8>& out, const void* src, const nString& typeName, Environment* env = nullptr);
+    // Read Data Written By writeBinary, Rejecting It If The Type Changed Since
+    Error readBinary(void* dest, const ui8* data, size_t size, Type* type, Environment* env = nullptr);
+    Error readBinary(void* dest, const ui8* data, size_t size, const nString& typeName, Environment* env = nullptr);
+
     VORB_INTERNAL Type& getType(bool& initialized, Type& type, bool (*fInit)());
     VORB_INTERNAL Enum& getEnum(bool& initialized, Enum& type, bool (*fInit)());
 }
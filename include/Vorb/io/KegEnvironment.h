@@ -69,9 +69,19 @@ namespace keg {
             if (kt != _enumsByID.end()) return kt->second;
             else return nullptr;
         }
+
+        // Copy The Dictionaries Into A Frozen Environment That Many Threads May Parse With At Once
+        // The Copy Refers To The Same Types, Which Must Outlive It And Not Change While It Is In Use
+        CALLER_DELETE Environment* snapshot() const;
+        // Frozen Environments Refuse New Types And Enums
+        bool isFrozen() const {
+            return _frozen;
+        }
     private:
         // Auto-Incrementing ID Counter
         ui32 _uuid;
+        // Set On Snapshots
+        bool _frozen;
 
         // Basic Parseable Types
         Type _internalTypes[TYPE_NUM_PREDEFINED];
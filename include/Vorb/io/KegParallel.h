@@ -0,0 +1,58 @@
+//
+// KegParallel.h
+// Vorb Engine
+//
+// Created on 16 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file KegParallel.h
+ * @brief Parsing many independent Keg files on a vcore::ThreadPool.
+ */
+
+#pragma once
+
+#ifndef Vorb_KegParallel_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_KegParallel_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <vector>
+
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include <exception>
+
+#include "Keg.h"
+#include "IOManager.h"
+#include "../ParallelFor.h"
+
+namespace keg {
+    /// Data parsed from many files, in the order of their paths
+    struct ParsedFiles {
+    public:
+        ArrayBase data; ///< One struct of the type per path, default constructed where parsing failed
+        std::vector<Error> errors; ///< Error of each path
+    };
+
+    /// Parse files into structs of one type, spreading the files over a thread pool
+    /// Parsing uses a frozen snapshot of the environment, taken on the calling thread unless env is already
+    /// frozen, so types may be registered again once this returns. Types must not change while it runs.
+    /// @tparam T: Worker data type of the pool
+    /// @param paths: Files to parse
+    /// @param type: Type of every file
+    /// @param pool: Pool whose workers parse files, the calling thread helps
+    /// @param env: Environment that resolves type names, or null for the global one
+    /// @param iom: Manager that resolves the paths, or null for one searching the working directory
+    /// @return Structs and errors in the order of the paths, Error::FILE_NOT_FOUND for files that could not be read
+    template<typename T>
+    ParsedFiles parseMany(const std::vector<vio::Path>& paths, Type* type, vcore::ThreadPool<T>& pool,
+                          Environment* env = nullptr, const vio::IOManager* iom = nullptr);
+}
+
+#include "KegParallel.inl"
+
+#endif // !Vorb_KegParallel_h__
@@ -0,0 +1,37 @@
+template<typename T>
+keg::ParsedFiles keg::parseMany(const std::vector<vio::Path>& paths, Type* type, vcore::ThreadPool<T>& pool,
+                                Environment* env /*= nullptr*/, const vio::IOManager* iom /*= nullptr*/) {
+    ParsedFiles files;
+    files.errors.resize(paths.size(), Error::BAD_ARGUMENT);
+    if (type == nullptr || paths.empty()) return files;
+
+    // Everything shared between threads is set up here, workers only read it
+    if (env == nullptr) env = getGlobalEnvironment();
+    Environment* snapshot = env->isFrozen() ? nullptr : env->snapshot();
+    Environment* frozen = snapshot ? snapshot : env;
+    vio::IOManager defaultIOM;
+    if (iom == nullptr) iom = &defaultIOM;
+    size_t size = type->getSizeInBytes();
+    files.data = ArrayBase(size);
+    files.data.ownData(type->allocArray(paths.size()), paths.size(), type->getDeallocator());
+    ui8* data = &files.data.at<ui8>(0);
+
+    vcore::parallelFor(pool, 0, paths.size(), 1, [&] (size_t b, size_t e) {
+        nString text;
+        for (size_t i = b; i < e; i++) {
+            if (!iom->readFileToString(paths[i], text)) {
+                files.errors[i] = Error::FILE_NOT_FOUND;
+                continue;
+            }
+            try {
+                files.errors[i] = parse(data + i * size, text.c_str(), type, frozen);
+            } catch (std::exception&) {
+                // Malformed YAML only fails its own file
+                files.errors[i] = Error::BAD_VALUE;
+            }
+        }
+    });
+
+    delete snapshot;
+    return files;
+}
@@ -0,0 +1,130 @@
+//
+// KegPlan.h
+// Vorb Engine
+//
+// Created on 16 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file KegPlan.h
+ * @brief Keg types compiled into flat lookup tables.
+ */
+
+#pragma once
+
+#ifndef Vorb_KegPlan_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_KegPlan_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <unordered_map>
+#include <vector>
+
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include "Keg.h"
+
+#define KEG_PLAN_NONE 0xFFFFFFFFu ///< Index of a missing layout or entry
+
+namespace keg {
+    class TypePlan;
+    struct PlanEntry;
+
+    /// Parses a node into the value of an entry
+    typedef void(*PlanReader)(ui8* dest, const PlanEntry& entry, const TypePlan& plan, Node node, ReadContext& context);
+
+    /// A value of a compiled type, with everything it references already resolved
+    struct PlanEntry {
+    public:
+        ui64 nameHash; ///< Hash of the key
+        const nString* name; ///< Key, owned by the type, or null for array elements
+        size_t offset; ///< Bytes of offset into the struct
+        PlanReader reader; ///< Parses the value
+        const Value* decl; ///< Declaration the entry was compiled from
+        Type* type; ///< Custom, pointed-to or element type
+        Enum* enumType; ///< Enum of an enum value
+        ui32 layout; ///< Compiled layout of a custom or pointed-to type
+        ui32 interior; ///< Entry of array elements
+    };
+
+    /// A keg::Type compiled into sorted tables of hashed keys
+    /// Parsing through a plan visits the same values with the same results as keg::parse, but finds each key by
+    /// binary search instead of a string map and resolves nested types, enums and arrays once when compiling.
+    /// Build one plan per type and reuse it. A plan must be rebuilt if its types change.
+    /// Loading the YAML document takes nearly all of the time of a parse, so a plan parses no faster than keg::parse.
+    /// Passed to keg::parseStream, a plan replaces the lookup of every key and nested type while streaming, but the
+    /// YAML parser still takes most of the time there too, so expect a small gain at best.
+    class TypePlan {
+    public:
+        /// Compile a type and every type it references
+        /// @param type: Type to compile
+        /// @param env: Environment that resolves type names, or null for the global one
+        void compile(Type* type, Environment* env = nullptr);
+
+        /// Parse a YAML document
+        /// @param dest: Destination struct of the compiled type
+        /// @param data: Data string in YAML format
+        /// @return Same error as keg::parse
+        Error parse(void* dest, const cString data) const;
+        /// Parse a mapped node with a compiled layout
+        /// @param dest: Destination struct of the layout's type
+        /// @param data: Mapped node
+        /// @param context: Reader and environment
+        /// @param layout: Layout index, 0 for the compiled type
+        /// @return Error::BAD_VALUE if data is not a map
+        Error parse(ui8* dest, Node data, ReadContext& context, ui32 layout = 0) const;
+
+        /// @param layout: Layout index
+        /// @param key: Key to look up
+        /// @param length: Length of the key
+        /// @return Entry for the key, or null
+        const PlanEntry* find(ui32 layout, const char* key, size_t length) const;
+        /// @param index: Entry index
+        /// @return An entry
+        const PlanEntry& getEntry(ui32 index) const {
+            return m_entries[index];
+        }
+
+        /// @return Type that was compiled
+        Type* getType() const {
+            return m_layouts.empty() ? nullptr : m_layouts[0].type;
+        }
+        /// @return Environment that resolved type names
+        Environment* getEnvironment() const {
+            return m_env;
+        }
+        /// @return Number of compiled types, including the root type
+        size_t getLayoutCount() const {
+            return m_layouts.size();
+        }
+    private:
+        /// The entries of one compiled type
+        struct Layout {
+            Type* type; ///< Compiled type
+            ui32 begin; ///< First entry, sorted by hash
+            ui32 end; ///< One past the last entry
+        };
+
+        /// Compile a type once
+        /// @return Layout index
+        ui32 addLayout(Type* type);
+        /// Compile a value declaration
+        /// @return Entry for the value
+        PlanEntry compileEntry(const nString* name, const Value* decl);
+
+        Environment* m_env = nullptr; ///< Resolves type names
+        std::vector<Layout> m_layouts; ///< Compiled types, the root type first
+        std::vector<PlanEntry> m_entries; ///< Entries of all layouts and array elements
+        std::unordered_map<Type*, ui32> m_layoutIndices; ///< Layout of each compiled type
+    };
+
+    /// @param key: Key to hash
+    /// @param length: Length of the key
+    /// @return Hash used to look up keys in a plan
+    ui64 hashPlanKey(const char* key, size_t length);
+}
+
+#endif // !Vorb_KegPlan_h__
@@ -21,6 +21,7 @@ namespace keg {
     struct YAMLNode {
     public:
         YAML::Node data;
+        bool isFree = false; ///< True while the node waits in its reader's recycled list
     };
     class YAMLEmitter {
     public:
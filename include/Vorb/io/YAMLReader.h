@@ -19,7 +19,7 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
-#include <unordered_set>
+#include <vector>
 
 #include "../types.h"
 #endif // !VORB_USING_PCH
@@ -28,6 +28,8 @@
 #include "../Event.hpp"
 #include "YAMLNode.h"
 
+#define YAML_READER_FIRST_BLOCK_NODES 256 ///< Nodes in a reader's first block, doubling with each block after
+
 namespace keg {
     /// Reads YAML data
     class YAMLReader {
@@ -36,6 +38,7 @@ namespace keg {
         /// @param data: Data string in YAML format
         void init(const cString data);
         /// Destroy all nodes created by this document (all nodes are now invalid)
+        /// Nodes live in blocks owned by the reader, which are released together.
         void dispose();
 
         /// @return The document's top-level node
@@ -56,7 +59,8 @@ namespace keg {
         CALLEE_DELETE Node getInterior(Node node, const nString& value) {
             return getInterior(node, value.c_str());
         }
-        /// Deallocates this node (invalidates it and its copies)
+        /// Deallocates this node (invalidates it and its copies), letting the reader reuse it
+        /// Freeing a node that is already free only clears the pointer.
         /// @param node: Node which will become null after being freed
         void free(Node& node);
 
@@ -69,8 +73,15 @@ namespace keg {
         /// @param f: Function to be invoked on each element - (index, value) -> void
         void forAllInSequence(Node node, Delegate<void, Sender, size_t, Node>* f);
     private:
-        Node m_first; ///< The root node in the data
-        std::unordered_set<Node> m_allocated; ///< List of allocated nodes
+        /// @return An empty node from the reader's blocks
+        Node allocNode();
+        /// @return True if the node lies in one of this reader's blocks
+        bool owns(Node node) const;
+
+        Node m_first = nullptr; ///< The root node in the data
+        std::vector<Node> m_blocks; ///< Node storage, each block twice the size of the one before
+        size_t m_blockUsed = 0; ///< Nodes handed out from the last block
+        std::vector<Node> m_recycled; ///< Freed nodes, reused before the blocks grow
     };
 }
 
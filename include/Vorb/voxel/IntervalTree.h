@@ -20,58 +20,67 @@
 
 #ifndef VORB_USING_PCH
 #include <map>
+#include <vector>
 
 #include "../types.h"
 #endif // !VORB_USING_PCH
 
+#include <algorithm>
+
+#include "../VorbAssert.hpp"
+
+#define INTERVAL_TREE_DEFAULT_VOLUME 32768 ///< Number of elements in a 32^3 chunk
+
 // Implementation of a specialized interval tree based on a red-black tree
 // Red black tree: http://en.wikipedia.org/wiki/Red%E2%80%93black_tree
 
-// NOTE: Currently only works for lengths 32768 and below
-// TODO(Ben): More templatey
+// NOTE: Works for volumes below 2^31, starts and lengths are 32-bit
 // TODO(Ben): Recombination
 // TODO(Ben): Refactor
 template <typename T>
 class IntervalTree {
 public:
 
-#define COLOR_BIT 0x8000u
-#define START_MASK 0x7FFFu
+#define COLOR_BIT 0x80000000u
+#define START_MASK 0x7FFFFFFFu
+
+    /// @param volume: Total length covered by the tree, used for validity checks
+    explicit IntervalTree(size_t volume = INTERVAL_TREE_DEFAULT_VOLUME) : m_volume(volume) {}
 
     // Lightweight node for initialization
     class LNode {
     public:
         LNode() {}
-        LNode(ui16 Start, ui16 Length, T Data) : start(Start), length(Length), data(Data) {}
-        void set(ui16 Start, ui16 Length, T Data) {
+        LNode(ui32 Start, ui32 Length, T Data) : start(Start), length(Length), data(Data) {}
+        void set(ui32 Start, ui32 Length, T Data) {
             start = Start;
             length = Length;
             data = Data;
         }
-        ui16 start;
-        ui16 length;
+        ui32 start;
+        ui32 length;
         T data;
     };
 
     class Node {
     public:
         Node() : left(-1), right(-1), parent(-2) {}
-        Node(T Data, ui16 start, ui16 Length) : length(Length), left(-1), right(-1), parent(-1), m_start(start | COLOR_BIT), data(Data)  {}
+        Node(T Data, ui32 start, ui32 Length) : length(Length), left(-1), right(-1), parent(-1), m_start(start | COLOR_BIT), data(Data)  {}
 
         inline void incrementStart() { ++m_start; }
         inline void decrementStart() { --m_start; }
-        inline ui16 getStart() const { return m_start & START_MASK; }
-        inline void setStart(ui16 Start) { m_start = (m_start & COLOR_BIT) | Start; }
+        inline ui32 getStart() const { return m_start & START_MASK; }
+        inline void setStart(ui32 Start) { m_start = (m_start & COLOR_BIT) | Start; }
         inline void paintRed() { m_start |= COLOR_BIT; }
         inline void paintBlack() { m_start &= START_MASK; }
         inline bool isRed() const { return (m_start & COLOR_BIT) != 0; }
 
-        ui16 length;
-        i16 left;
-        i16 right;
-        i16 parent;
+        ui32 length;
+        i32 left;
+        i32 right;
+        i32 parent;
     private:
-        ui16 m_start; //also stores color
+        ui32 m_start; //also stores color
     public:
         T data;
     };
@@ -109,19 +118,23 @@ public:
         std::vector <Node>* m_tree;
     };
 
+    /// Reserve memory so that initialization and insertion do not allocate until the tree exceeds it
+    /// @param nodes: Number of intervals to make room for
+    void reserve(size_t nodes);
+
     void initSingle(T data, size_t length);
     void initFromSortedArray(const std::vector <LNode>& data);
     void initFromSortedArray(const LNode data[], size_t size);
 
     bool checkTreeValidity() const {
-        int tot = 0;
+        size_t tot = 0;
         for (size_t i = 0; i < m_tree.size(); i++) {
-            if (m_tree[i].length > 32768) {
+            if (m_tree[i].length > m_volume) {
                 return false;
             }
             tot += m_tree[i].length;
         }
-        if (tot != 32768) {
+        if (tot != m_volume) {
             return false;
         }
 
@@ -158,11 +171,32 @@ public:
 
     const T& getData(size_t index) const;
     //Get the enclosing interval for a given point
-    i16 getInterval(size_t index) const;
+    i32 getInterval(size_t index) const;
 
     Node* insert(size_t index, T data);
 
-    void uncompressIntoBuffer(T* buffer);
+    /// Set every element of a range, rebuilding the tree once instead of inserting per element
+    /// Every call rebuilds the whole tree, so it only pays off for runs of many elements. Use insert for single elements.
+    /// @param start: First element
+    /// @param end: Element after the last one
+    /// @param data: New value
+    void fillRange(size_t start, size_t end, T data);
+    /// Set every element of a box in a cubic volume accessed Y-Z-X, rebuilding the tree once
+    /// Like fillRange, every call rebuilds the whole tree.
+    /// @pre: getVolume() is a cube
+    /// @param min: Lowest corner of the box
+    /// @param max: Corner past the highest one, exclusive on every axis and at most the side of the volume
+    /// @param data: New value
+    void fillBox(const ui32v3& min, const ui32v3& max, T data);
+
+    /// Call f(node) for every interval in order, walking through parent links
+    /// @param f: Callable as f(const Node&)
+    template<typename F>
+    void forEachInterval(F f) const;
+
+    /// Write every element in order, filling each interval as one run
+    /// @param buffer: Output array of getVolume() elements
+    void uncompressIntoBuffer(T* buffer) const;
 
     iterator begin() { 
         if (m_root == -1) return iterator(nullptr, nullptr);
@@ -178,9 +212,22 @@ public:
 
     inline const Node& operator[](int index) const { return m_tree[index]; }
     inline size_t size() const { return m_tree.size(); }
+    /// @return Number of intervals that fit without allocating
+    inline size_t capacity() const { return m_tree.capacity(); }
+    /// @return Total length covered by the tree
+    inline size_t getVolume() const { return m_volume; }
+    /// @param volume: Total length covered by the tree
+    inline void setVolume(size_t volume) { m_volume = volume; }
 
 private:
-    void uncompressTraversal(int index, int& bufferIndex, T* buffer);
+    /// A range of elements to overwrite
+    struct FillRange {
+        ui32 start;
+        ui32 end;
+    };
+
+    /// Overwrite sorted, disjoint ranges and rebuild the tree from the merged intervals
+    void applyFill(const FillRange* ranges, size_t count, T data);
 
     int arrayToRedBlackTree(int i, int j, int parent, bool isBlack) {
         if (i > j) return -1;
@@ -221,18 +268,20 @@ private:
     void rotateLeft(int index);
 
     int m_root = -1;
+    size_t m_volume;
     std::vector <Node> m_tree;
 
     class NodeToAdd {
     public:
-        NodeToAdd(i16 Parent, ui16 Length, T Data) : start(Parent), length(Length), data(Data) {}
-        i16 start;
-        ui16 length;
+        NodeToAdd(ui32 Start, ui32 Length, T Data) : start(Start), length(Length), data(Data) {}
+        ui32 start;
+        ui32 length;
         T data;
     };
 
     std::vector <NodeToAdd> m_nodesToAdd;
-    std::vector <ui16> m_nodesToRemove;
+    std::vector <LNode> m_fillNodes; ///< Merged intervals of the last fill
+    std::vector <FillRange> m_fillRanges; ///< Rows of the last box fill
 };
 
 #include "IntervalTree.inl"
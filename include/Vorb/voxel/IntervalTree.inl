@@ -1,5 +1,15 @@
+template <typename T>
+inline void IntervalTree<T>::reserve(size_t nodes) {
+    m_tree.reserve(nodes);
+    m_fillNodes.reserve(nodes);
+    // An insertion splits at most one interval at a time
+    m_nodesToAdd.reserve(4);
+}
+
 template <typename T>
 inline void IntervalTree<T>::initSingle(T data, size_t length) {
+    m_tree.clear();
+    m_nodesToAdd.clear();
     m_root = 0;
     m_tree.emplace_back(data, 0, length);
     m_tree[0].paintBlack();
@@ -7,17 +17,12 @@ inline void IntervalTree<T>::initSingle(T data, size_t length) {
 
 template <typename T>
 void IntervalTree<T>::initFromSortedArray(const std::vector <LNode>& data) {
-    m_tree.resize(data.size());
-    for (size_t i = 0; i < m_tree.size(); i++) {
-        m_tree[i].setStart(data[i].start);
-        m_tree[i].length = data[i].length;
-        m_tree[i].data = data[i].data;
-    }
-    m_root = arrayToRedBlackTree(0, data.size() - 1, -1, true);
+    initFromSortedArray(data.data(), data.size());
 }
 
 template <typename T>
 inline void IntervalTree<T>::initFromSortedArray(const LNode data[], size_t size) {
+    m_nodesToAdd.clear();
     m_tree.resize(size);
     for (size_t i = 0; i < size; i++) {
         m_tree[i].setStart(data[i].start);
@@ -31,7 +36,8 @@ template <typename T>
 inline void IntervalTree<T>::clear() {
     std::vector<Node>().swap(m_tree);
     std::vector<NodeToAdd>().swap(m_nodesToAdd);
-    std::vector<ui16>().swap(m_nodesToRemove);
+    std::vector<LNode>().swap(m_fillNodes);
+    std::vector<FillRange>().swap(m_fillRanges);
     m_root = -1;
 }
 
@@ -42,16 +48,10 @@ inline const T& IntervalTree<T>::getData(size_t index) const {
 
 //Get the enclosing interval for a given point
 template <typename T>
-i16 IntervalTree<T>::getInterval(size_t index) const {
+i32 IntervalTree<T>::getInterval(size_t index) const {
     i32 interval = m_root;
     while (true) {
-
-        // TODO(Ben): Error checking. Ideally we can remove this when we are certain this condition can never happen
-        if (interval < 0 || interval >= (i32)m_tree.size()) {
-            std::cout << "getInterval failed! Looking for index: " << index << " Interval is " << interval << std::endl;
-            int a;
-            std::cin >> a;
-        }
+        vorb_assert(interval >= 0 && interval < (i32)m_tree.size(), "getInterval failed! Looking for index: " << index << " Interval is " << interval);
 
         const Node& node = m_tree[interval];
 
@@ -221,7 +221,7 @@ inline int IntervalTree<T>::getUncle(Node* node, Node** grandParent) {
 template <typename T>
 inline void IntervalTree<T>::rotateParentLeft(int index, Node* grandParent) {
     Node& node = m_tree[index];
-    i16 parentIndex = node.parent;
+    i32 parentIndex = node.parent;
     Node& parent = m_tree[parentIndex];
 
     node.parent = parent.parent;
@@ -239,7 +239,7 @@ inline void IntervalTree<T>::rotateParentLeft(int index, Node* grandParent) {
 template <typename T>
 inline void IntervalTree<T>::rotateParentRight(int index, Node* grandParent) {
     Node& node = m_tree[index];
-    i16 parentIndex = node.parent;
+    i32 parentIndex = node.parent;
     Node& parent = m_tree[parentIndex];
 
     node.parent = parent.parent;
@@ -259,7 +259,7 @@ inline void IntervalTree<T>::rotateRight(int index) {
     Node& node = m_tree.at(index);
     Node& left = m_tree.at(node.left);
 
-    i16 right = left.right;
+    i32 right = left.right;
     left.right = index;
     left.parent = node.parent;
 
@@ -286,7 +286,7 @@ inline void IntervalTree<T>::rotateLeft(int index) {
     Node& node = m_tree.at(index);
     Node& right = m_tree.at(node.right);
 
-    i16 left = right.left;
+    i32 left = right.left;
     right.left = index;
     right.parent = node.parent;
 
@@ -307,22 +307,103 @@ inline void IntervalTree<T>::rotateLeft(int index) {
 }
 
 template <typename T>
-void IntervalTree<T>::uncompressTraversal(int index, int& bufferIndex, T* buffer) {
-    if (m_tree[index].left != -1) {
-        uncompressTraversal(m_tree[index].left, bufferIndex, buffer);
-    }
-    for (int i = 0; i < m_tree[index].length; i++) {
-        buffer[bufferIndex++] = m_tree[index].data;
+template <typename F>
+void IntervalTree<T>::forEachInterval(F f) const {
+    if (m_root == -1) return;
+
+    // In-order walk through parent links, so no stack is needed
+    i32 index = m_root;
+    while (m_tree[index].left != -1) index = m_tree[index].left;
+    while (index != -1) {
+        const Node& node = m_tree[index];
+        f(node);
+
+        if (node.right != -1) {
+            index = node.right;
+            while (m_tree[index].left != -1) index = m_tree[index].left;
+        } else {
+            i32 child = index;
+            index = node.parent;
+            while (index != -1 && m_tree[index].right == child) {
+                child = index;
+                index = m_tree[index].parent;
+            }
+        }
     }
-    if (m_tree[index].right != -1) {
-        uncompressTraversal(m_tree[index].right, bufferIndex, buffer);
+}
+
+template <typename T>
+void IntervalTree<T>::uncompressIntoBuffer(T* buffer) const {
+    forEachInterval([&] (const Node& node) {
+        // Whole-run fills become memset or vector stores
+        buffer = std::fill_n(buffer, node.length, node.data);
+    });
+}
+
+template <typename T>
+void IntervalTree<T>::fillRange(size_t start, size_t end, T data) {
+    if (start >= end) return;
+    FillRange range = { (ui32)start, (ui32)end };
+    applyFill(&range, 1, data);
+}
+
+template <typename T>
+void IntervalTree<T>::fillBox(const ui32v3& min, const ui32v3& max, T data) {
+    if (min.x >= max.x || min.y >= max.y || min.z >= max.z) return;
+    size_t side = 1;
+    while (side * side * side < m_volume) side++;
+    vorb_assert(side * side * side == m_volume, "fillBox needs a cubic volume, got " << m_volume);
+    vorb_assert(max.x <= side && max.y <= side && max.z <= side, "fillBox box ends past the volume's side of " << side);
+
+    // One range per X row, already sorted by the Y-Z-X layout
+    m_fillRanges.clear();
+    for (ui32 y = min.y; y < max.y; y++) {
+        for (ui32 z = min.z; z < max.z; z++) {
+            ui32 rowStart = (ui32)((y * side + z) * side);
+            m_fillRanges.push_back({ rowStart + min.x, rowStart + max.x });
+        }
     }
+    applyFill(m_fillRanges.data(), m_fillRanges.size(), data);
 }
 
 template <typename T>
-void IntervalTree<T>::uncompressIntoBuffer(T* buffer) {
-    int bufferIndex = 0;
-    uncompressTraversal(m_root, bufferIndex, buffer);
+void IntervalTree<T>::applyFill(const FillRange* ranges, size_t count, T data) {
+    m_fillNodes.clear();
+    auto emit = [&] (ui32 start, ui32 length, const T& value) {
+        if (!length) return;
+        if (!m_fillNodes.empty()) {
+            LNode& back = m_fillNodes.back();
+            if (back.data == value && back.start + back.length == start) {
+                back.length += length;
+                return;
+            }
+        }
+        m_fillNodes.emplace_back(start, length, value);
+    };
+
+    // Merge the ranges into the intervals in a single pass
+    size_t r = 0;
+    forEachInterval([&] (const Node& node) {
+        ui32 cursor = node.getStart();
+        ui32 end = cursor + node.length;
+        while (cursor < end) {
+            while (r < count && ranges[r].end <= cursor) r++;
+            if (r == count || ranges[r].start >= end) {
+                emit(cursor, end - cursor, node.data);
+                break;
+            }
+            if (ranges[r].start > cursor) {
+                emit(cursor, ranges[r].start - cursor, node.data);
+                cursor = ranges[r].start;
+            }
+            ui32 fillEnd = std::min(ranges[r].end, end);
+            emit(cursor, fillEnd - cursor, data);
+            cursor = fillEnd;
+        }
+    });
+
+    // Rebalance once
+    initFromSortedArray(m_fillNodes.data(), m_fillNodes.size());
 }
 
 template <typename T>
@@ -0,0 +1,173 @@
+//
+// PaddedChunk.h
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file PaddedChunk.h
+ * @brief Builds the padded voxel buffers that the meshers take, straight from compressed chunks.
+ */
+
+#pragma once
+
+#ifndef Vorb_PaddedChunk_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_PaddedChunk_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include <algorithm>
+
+#include "IntervalTree.h"
+#include "VoxCommon.h"
+
+namespace vorb {
+    namespace voxel {
+        /// Call f(y, z, x0, x1, data) for every part of a cubic chunk's intervals that lies in one X row
+        /// @param tree: Chunk of width^3 elements accessed Y-Z-X
+        /// @param width: Width of the chunk
+        /// @param f: Callable as f(ui32 y, ui32 z, ui32 x0, ui32 x1, const T& data), where x1 is exclusive
+        template<typename T, typename F>
+        inline void forEachChunkRow(const IntervalTree<T>& tree, ui32 width, F f) {
+            tree.forEachInterval([&] (const typename IntervalTree<T>::Node& node) {
+                ui32 index = node.getStart();
+                ui32 end = index + node.length;
+                while (index < end) {
+                    ui32 row = index / width;
+                    ui32 x0 = index - row * width;
+                    ui32 x1 = std::min(width, x0 + (end - index));
+                    f(row / width, row % width, x0, x1, node.data);
+                    index += x1 - x0;
+                }
+            });
+        }
+
+        /// Index of the chunk at an offset in [-1, 1] on each axis, in the 27 entries taken by buildPaddedNeighbourhood
+        /// @param x: Offset on the X-axis
+        /// @param y: Offset on the Y-axis
+        /// @param z: Offset on the Z-axis
+        /// @return Index accessed Y-Z-X, 13 being the center
+        inline ui32 paddedNeighbourIndex(i32 x, i32 y, i32 z) {
+            return (ui32)((y + 1) * 9 + (z + 1) * 3 + (x + 1));
+        }
+
+        /// Decompress a chunk and the facing layers of its neighbours into a (width + 2)^3 buffer
+        /// The result is what createCulled, createCulledBitmask and createGreedy take: they mesh the
+        /// interior and emit the faces it shows towards its neighbours. Intervals are written in place,
+        /// with no intermediate buffer. Only the six face layers of the padding are read from
+        /// neighbours, the padding's edges and corners hold the fill value. createCulledAO reads those
+        /// edges and corners for the occupancy around border faces, so use buildPaddedNeighbourhood for it.
+        /// @param center: Chunk of width^3 elements accessed Y-Z-X
+        /// @param neighbours: Chunks adjacent to the center, indexed by Cardinal (X_NEG, X_POS, Y_NEG, ...), null where missing
+        /// @param width: Width of a chunk
+        /// @param padded: Output array of (width + 2)^3 elements accessed Y-Z-X
+        /// @param fill: Value of padding without a neighbour
+        template<typename T>
+        inline void buildPaddedChunk(const IntervalTree<T>& center, const IntervalTree<T>* const* neighbours, ui32 width, T* padded, const T& fill) {
+            size_t p1 = width + 2;
+            size_t p2 = p1 * p1;
+            ui32 last = width + 1;
+
+            // Padding shell: whole bottom and top layers, then the border of every layer between
+            std::fill_n(padded, p2, fill);
+            std::fill_n(padded + last * p2, p2, fill);
+            for (ui32 y = 1; y < last; y++) {
+                T* layer = padded + y * p2;
+                std::fill_n(layer, p1, fill);
+                std::fill_n(layer + last * p1, p1, fill);
+                for (ui32 z = 1; z < last; z++) {
+                    layer[z * p1] = fill;
+                    layer[z * p1 + last] = fill;
+                }
+            }
+
+            forEachChunkRow(center, width, [&] (ui32 y, ui32 z, ui32 x0, ui32 x1, const T& data) {
+                std::fill_n(padded + (y + 1) * p2 + (z + 1) * p1 + x0 + 1, x1 - x0, data);
+            });
+
+            for (ui32 d = 0; d < 6; d++) {
+                if (!neighbours[d]) continue;
+                Cardinal direction = (Cardinal)d;
+                bool positive = (direction & Cardinal::POSITIVE) == Cardinal::POSITIVE;
+                // The neighbour's layer that touches the center, and where it goes in the padding
+                ui32 source = positive ? 0 : width - 1;
+                ui32 dest = positive ? last : 0;
+                switch (toAxis(direction)) {
+                case Axis::X:
+                    forEachChunkRow(*neighbours[d], width, [&] (ui32 y, ui32 z, ui32 x0, ui32 x1, const T& data) {
+                        if (source >= x0 && source < x1) padded[(y + 1) * p2 + (z + 1) * p1 + dest] = data;
+                    });
+                    break;
+                case Axis::Y:
+                    forEachChunkRow(*neighbours[d], width, [&] (ui32 y, ui32 z, ui32 x0, ui32 x1, const T& data) {
+                        if (y == source) std::fill_n(padded + dest * p2 + (z + 1) * p1 + x0 + 1, x1 - x0, data);
+                    });
+                    break;
+                default:
+                    forEachChunkRow(*neighbours[d], width, [&] (ui32 y, ui32 z, ui32 x0, ui32 x1, const T& data) {
+                        if (z == source) std::fill_n(padded + (y + 1) * p2 + dest * p1 + x0 + 1, x1 - x0, data);
+                    });
+                    break;
+                }
+            }
+        }
+
+        /// Decompress a chunk and its full neighbourhood into a (width + 2)^3 buffer
+        /// Like buildPaddedChunk, but the padding's edges and corners are also read from the chunks
+        /// that touch the center along an edge or at a corner, which createCulledAO needs to shade
+        /// border faces. Those cells are looked up one at a time, since there are only 12 * width + 8.
+        /// @param center: Chunk of width^3 elements accessed Y-Z-X
+        /// @param neighbours: 27 chunks indexed by paddedNeighbourIndex, null where missing, the center entry is ignored
+        /// @param width: Width of a chunk
+        /// @param padded: Output array of (width + 2)^3 elements accessed Y-Z-X
+        /// @param fill: Value of padding without a neighbour
+        template<typename T>
+        inline void buildPaddedNeighbourhood(const IntervalTree<T>& center, const IntervalTree<T>* const* neighbours, ui32 width, T* padded, const T& fill) {
+            const IntervalTree<T>* faces[6] = {
+                neighbours[paddedNeighbourIndex(-1, 0, 0)], neighbours[paddedNeighbourIndex(1, 0, 0)],
+                neighbours[paddedNeighbourIndex(0, -1, 0)], neighbours[paddedNeighbourIndex(0, 1, 0)],
+                neighbours[paddedNeighbourIndex(0, 0, -1)], neighbours[paddedNeighbourIndex(0, 0, 1)]
+            };
+            buildPaddedChunk(center, faces, width, padded, fill);
+
+            size_t p1 = width + 2;
+            size_t p2 = p1 * p1;
+            for (i32 dy = -1; dy <= 1; dy++) {
+                for (i32 dz = -1; dz <= 1; dz++) {
+                    for (i32 dx = -1; dx <= 1; dx++) {
+                        // Faces and the center are done, missing chunks keep the fill
+                        if ((dx != 0) + (dy != 0) + (dz != 0) < 2) continue;
+                        const IntervalTree<T>* tree = neighbours[paddedNeighbourIndex(dx, dy, dz)];
+                        if (!tree) continue;
+
+                        // Per axis, the neighbour's cells that touch the center and where they go in the padding
+                        i32 offsets[3] = { dx, dy, dz };
+                        ui32 source[3], dest[3], count[3];
+                        for (ui32 a = 0; a < 3; a++) {
+                            source[a] = (offsets[a] < 0) ? width - 1 : 0;
+                            dest[a] = (offsets[a] < 0) ? 0 : ((offsets[a] > 0) ? width + 1 : 1);
+                            count[a] = offsets[a] ? 1 : width;
+                        }
+                        for (ui32 y = 0; y < count[1]; y++) {
+                            for (ui32 z = 0; z < count[2]; z++) {
+                                for (ui32 x = 0; x < count[0]; x++) {
+                                    size_t index = (source[1] + y) * width * width + (source[2] + z) * width + source[0] + x;
+                                    padded[(dest[1] + y) * p2 + (dest[2] + z) * p1 + dest[0] + x] = tree->getData(index);
+                                }
+                            }
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+namespace vvox = vorb::voxel;
+
+#endif // !Vorb_PaddedChunk_h__
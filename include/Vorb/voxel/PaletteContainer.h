@@ -0,0 +1,146 @@
+//
+// PaletteContainer.h
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file PaletteContainer.h
+ * @brief Compressed voxel storage using a palette of bit-packed indices, with a run-length fallback.
+ */
+
+#pragma once
+
+#ifndef Vorb_PaletteContainer_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_PaletteContainer_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <unordered_map>
+#include <vector>
+
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include <algorithm>
+
+#define PALETTE_CONTAINER_DEFAULT_VOLUME 32768 ///< Number of elements in a 32^3 chunk
+#define PALETTE_CONTAINER_LINEAR_SEARCH 16 ///< Largest palette that is searched without a lookup table
+
+namespace vorb {
+    namespace voxel {
+        /// Voxel storage with the same access surface as IntervalTree
+        /// Each element is an index into a palette of distinct values, packed at 0, 4, 8, 16 or 32 bits
+        /// depending on the palette size. Data with few long runs may instead be stored as sorted runs,
+        /// which is picked on initialization or compact() when it is smaller than the packed indices.
+        /// @tparam T: Voxel data type, which must always have a std::hash specialization and operator==,
+        /// since the lookup table used once palettes outgrow linear search is part of every container
+        template<typename T>
+        class PaletteContainer {
+        public:
+            /// @param volume: Number of elements
+            /// @param allowRLE: True to store data as runs when that is smaller
+            explicit PaletteContainer(size_t volume = PALETTE_CONTAINER_DEFAULT_VOLUME, bool allowRLE = true);
+
+            /// Fill every element with one value
+            /// @param data: Value of all elements
+            void initSingle(T data);
+            /// Compress an array of elements
+            /// @param data: Array of getVolume() elements
+            void initFromBuffer(const T* data);
+            /// Free all storage, leaving every element as a default T
+            void clear();
+
+            /// @param index: Element index
+            /// @return Value of the element
+            const T& getData(size_t index) const;
+            /// Set the value of an element
+            /// Run storage switches to palette storage once it holds too many runs.
+            /// @param index: Element index
+            /// @param data: New value
+            void insert(size_t index, T data);
+
+            /// Write every element in order
+            /// @param buffer: Output array of getVolume() elements
+            void uncompressIntoBuffer(T* buffer) const;
+            /// Rebuild storage, dropping unused palette entries and picking the smaller representation
+            void compact();
+
+            /// @return Number of elements
+            size_t getVolume() const {
+                return m_volume;
+            }
+            /// @return True if data is stored as runs
+            bool isRLE() const {
+                return m_isRLE;
+            }
+            /// @return Bits used by each packed index, 0 when all elements share one value or data is stored as runs
+            ui32 getBitsPerIndex() const {
+                return m_bits;
+            }
+            /// @return Number of palette slots, including unused ones waiting to be reused
+            size_t getPaletteSize() const {
+                return m_palette.size();
+            }
+            /// @return Number of runs while data is stored as runs
+            size_t getRunCount() const {
+                return m_runs.size();
+            }
+            /// @return Approximate heap and object memory used, in bytes
+            size_t getMemoryUsage() const;
+        private:
+            /// A run of equal elements ending where the next run starts
+            struct Run {
+                ui32 start; ///< First element of the run
+                T data; ///< Value of the run
+            };
+
+            /// @return Smallest supported index width that addresses n palette entries
+            static ui32 bitsFor(size_t n);
+            /// @return Palette index of an element
+            ui32 getIndex(size_t index) const {
+                if (m_bits == 0) return 0;
+                size_t bit = index * m_bits;
+                return (ui32)((m_indices[bit >> 6] >> (bit & 63)) & ((1ull << m_bits) - 1));
+            }
+            /// Store the palette index of an element
+            void setIndex(size_t index, ui32 p) {
+                size_t bit = index * m_bits;
+                ui64 mask = ((1ull << m_bits) - 1) << (bit & 63);
+                ui64& word = m_indices[bit >> 6];
+                word = (word & ~mask) | (((ui64)p << (bit & 63)) & mask);
+            }
+            /// Change the index width, repacking every element
+            void repack(ui32 bits);
+            /// @return Palette slot holding a value, or UINT32_MAX
+            ui32 findPalette(const T& data) const;
+            /// @return Palette slot for a value, adding it and widening indices when needed
+            ui32 addPalette(const T& data);
+            /// @return Run containing an element
+            size_t findRun(size_t index) const;
+            /// Join runs with equal values in a range of run positions
+            void mergeRuns(size_t first, size_t last);
+            /// Switch from runs to palette storage
+            void convertToPalette();
+
+            size_t m_volume; ///< Number of elements
+            bool m_allowRLE; ///< True if run storage may be used
+            bool m_isRLE = false; ///< True while data is stored as runs
+            ui32 m_bits = 0; ///< Width of a packed index
+            std::vector<T> m_palette; ///< Distinct values, indexed by packed indices
+            std::vector<ui32> m_counts; ///< Number of elements using each palette slot
+            std::vector<ui32> m_freeSlots; ///< Palette slots whose count dropped to zero
+            std::unordered_map<T, ui32> m_lookup; ///< Palette slots by value, used once the palette outgrows linear search
+            std::vector<ui64> m_indices; ///< Packed palette indices
+            std::vector<Run> m_runs; ///< Sorted runs while data is stored as runs
+        };
+    }
+}
+namespace vvox = vorb::voxel;
+
+#include "PaletteContainer.inl"
+
+#endif // !Vorb_PaletteContainer_h__
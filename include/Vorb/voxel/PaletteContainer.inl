@@ -0,0 +1,274 @@
+template <typename T>
+vvox::PaletteContainer<T>::PaletteContainer(size_t volume /*= PALETTE_CONTAINER_DEFAULT_VOLUME*/, bool allowRLE /*= true*/) :
+    m_volume(volume),
+    m_allowRLE(allowRLE) {
+    initSingle(T());
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::initSingle(T data) {
+    m_isRLE = false;
+    m_bits = 0;
+    m_palette.assign(1, data);
+    m_counts.assign(1, (ui32)m_volume);
+    m_freeSlots.clear();
+    m_lookup.clear();
+    std::vector<ui64>().swap(m_indices);
+    std::vector<Run>().swap(m_runs);
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::initFromBuffer(const T* data) {
+    m_isRLE = false;
+    m_bits = 0;
+    m_palette.clear();
+    m_counts.clear();
+    m_freeSlots.clear();
+    m_lookup.clear();
+
+    // Gather the palette and count runs in one pass
+    size_t runs = 1;
+    ui32 p = 0;
+    for (size_t i = 0; i < m_volume; i++) {
+        if (i == 0 || !(data[i] == data[i - 1])) {
+            if (i != 0) runs++;
+            p = findPalette(data[i]);
+            if (p == UINT32_MAX) {
+                m_palette.push_back(data[i]);
+                m_counts.push_back(0);
+                p = (ui32)m_palette.size() - 1;
+                if (m_palette.size() > PALETTE_CONTAINER_LINEAR_SEARCH) {
+                    if (m_lookup.empty()) {
+                        for (ui32 s = 0; s < m_palette.size(); s++) m_lookup[m_palette[s]] = s;
+                    } else {
+                        m_lookup[data[i]] = p;
+                    }
+                }
+            }
+        }
+        m_counts[p]++;
+    }
+
+    ui32 bits = bitsFor(m_palette.size());
+    if (m_allowRLE && runs * sizeof(Run) < m_volume * bits / 8) {
+        m_isRLE = true;
+        m_runs.clear();
+        m_runs.reserve(runs);
+        for (size_t i = 0; i < m_volume; i++) {
+            if (i == 0 || !(data[i] == data[i - 1])) m_runs.push_back(Run{ (ui32)i, data[i] });
+        }
+        std::vector<T>().swap(m_palette);
+        std::vector<ui32>().swap(m_counts);
+        std::vector<ui64>().swap(m_indices);
+        m_lookup.clear();
+        return;
+    }
+
+    std::vector<Run>().swap(m_runs);
+    m_bits = bits;
+    if (m_bits == 0) {
+        std::vector<ui64>().swap(m_indices);
+        return;
+    }
+    m_indices.assign((m_volume * m_bits + 63) / 64, 0);
+    for (size_t i = 0; i < m_volume; i++) {
+        if (i == 0 || !(data[i] == data[i - 1])) p = findPalette(data[i]);
+        setIndex(i, p);
+    }
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::clear() {
+    std::vector<T>().swap(m_palette);
+    std::vector<ui32>().swap(m_counts);
+    std::vector<ui32>().swap(m_freeSlots);
+    std::unordered_map<T, ui32>().swap(m_lookup);
+    initSingle(T());
+}
+
+template <typename T>
+inline const T& vvox::PaletteContainer<T>::getData(size_t index) const {
+    if (m_isRLE) return m_runs[findRun(index)].data;
+    return m_palette[getIndex(index)];
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::insert(size_t index, T data) {
+    if (m_isRLE) {
+        size_t r = findRun(index);
+        Run& run = m_runs[r];
+        if (run.data == data) return;
+
+        size_t start = run.start;
+        size_t end = (r + 1 < m_runs.size()) ? m_runs[r + 1].start : m_volume;
+        if (end - start == 1) {
+            run.data = data;
+        } else if (index == start) {
+            run.start++;
+            m_runs.insert(m_runs.begin() + r, Run{ (ui32)index, data });
+        } else if (index == end - 1) {
+            m_runs.insert(m_runs.begin() + r + 1, Run{ (ui32)index, data });
+            r++;
+        } else {
+            Run split[2] = { Run{ (ui32)index, data }, Run{ (ui32)index + 1, run.data } };
+            m_runs.insert(m_runs.begin() + r + 1, split, split + 2);
+            r++;
+        }
+        mergeRuns(r == 0 ? 0 : r - 1, std::min(r + 1, m_runs.size() - 1));
+
+        // Once runs outgrow 4-bit indices, packing is never worse
+        if (m_runs.size() * sizeof(Run) > m_volume / 2) convertToPalette();
+        return;
+    }
+
+    ui32 old = getIndex(index);
+    if (m_palette[old] == data) return;
+
+    // Release the old value first so that its slot may be reused for the new one
+    if (--m_counts[old] == 0) {
+        m_freeSlots.push_back(old);
+        if (m_palette.size() > PALETTE_CONTAINER_LINEAR_SEARCH) m_lookup.erase(m_palette[old]);
+    }
+    ui32 p = addPalette(data);
+    if (m_bits) setIndex(index, p);
+    m_counts[p]++;
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::uncompressIntoBuffer(T* buffer) const {
+    if (m_isRLE) {
+        for (size_t r = 0; r < m_runs.size(); r++) {
+            size_t end = (r + 1 < m_runs.size()) ? m_runs[r + 1].start : m_volume;
+            std::fill_n(buffer + m_runs[r].start, end - m_runs[r].start, m_runs[r].data);
+        }
+        return;
+    }
+    if (m_bits == 0) {
+        std::fill_n(buffer, m_volume, m_palette[0]);
+        return;
+    }
+
+    // Decode a word at a time
+    size_t perWord = 64 / m_bits;
+    ui64 mask = (1ull << m_bits) - 1;
+    size_t i = 0;
+    for (size_t w = 0; i < m_volume; w++) {
+        ui64 word = m_indices[w];
+        for (size_t j = 0; j < perWord && i < m_volume; j++, i++) {
+            buffer[i] = m_palette[word & mask];
+            word >>= m_bits;
+        }
+    }
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::compact() {
+    std::vector<T> buffer(m_volume);
+    uncompressIntoBuffer(buffer.data());
+    initFromBuffer(buffer.data());
+}
+
+template <typename T>
+size_t vvox::PaletteContainer<T>::getMemoryUsage() const {
+    size_t bytes = sizeof(*this);
+    bytes += m_palette.capacity() * sizeof(T);
+    bytes += (m_counts.capacity() + m_freeSlots.capacity()) * sizeof(ui32);
+    bytes += m_indices.capacity() * sizeof(ui64);
+    bytes += m_runs.capacity() * sizeof(Run);
+    // Hash nodes hold the pair plus a link and a cached hash
+    bytes += m_lookup.bucket_count() * sizeof(void*);
+    bytes += m_lookup.size() * (sizeof(std::pair<const T, ui32>) + 2 * sizeof(void*));
+    return bytes;
+}
+
+template <typename T>
+inline ui32 vvox::PaletteContainer<T>::bitsFor(size_t n) {
+    if (n <= 1) return 0;
+    if (n <= 16) return 4;
+    if (n <= 256) return 8;
+    if (n <= 65536) return 16;
+    return 32;
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::repack(ui32 bits) {
+    std::vector<ui64> old((m_volume * bits + 63) / 64, 0);
+    old.swap(m_indices);
+    ui32 oldBits = m_bits;
+    ui64 oldMask = (1ull << oldBits) - 1;
+
+    m_bits = bits;
+    for (size_t i = 0; i < m_volume; i++) {
+        size_t bit = i * oldBits;
+        ui32 p = oldBits ? (ui32)((old[bit >> 6] >> (bit & 63)) & oldMask) : 0;
+        setIndex(i, p);
+    }
+}
+
+template <typename T>
+inline ui32 vvox::PaletteContainer<T>::findPalette(const T& data) const {
+    if (m_palette.size() > PALETTE_CONTAINER_LINEAR_SEARCH) {
+        auto kvp = m_lookup.find(data);
+        return (kvp == m_lookup.end()) ? UINT32_MAX : kvp->second;
+    }
+    // Slots with a count of zero are free and may hold stale values
+    for (ui32 i = 0; i < m_palette.size(); i++) {
+        if (m_counts[i] && m_palette[i] == data) return i;
+    }
+    return UINT32_MAX;
+}
+
+template <typename T>
+ui32 vvox::PaletteContainer<T>::addPalette(const T& data) {
+    ui32 p = findPalette(data);
+    if (p != UINT32_MAX) return p;
+
+    if (!m_freeSlots.empty()) {
+        p = m_freeSlots.back();
+        m_freeSlots.pop_back();
+        m_palette[p] = data;
+        if (m_palette.size() > PALETTE_CONTAINER_LINEAR_SEARCH) m_lookup[data] = p;
+        return p;
+    }
+
+    m_palette.push_back(data);
+    m_counts.push_back(0);
+    p = (ui32)m_palette.size() - 1;
+    if (m_palette.size() == PALETTE_CONTAINER_LINEAR_SEARCH + 1) {
+        // Switch to the lookup table, skipping free slots
+        for (ui32 s = 0; s < m_palette.size(); s++) {
+            if (m_counts[s] || s == p) m_lookup[m_palette[s]] = s;
+        }
+    } else if (m_palette.size() > PALETTE_CONTAINER_LINEAR_SEARCH) {
+        m_lookup[data] = p;
+    }
+
+    ui32 bits = bitsFor(m_palette.size());
+    if (bits != m_bits) repack(bits);
+    return p;
+}
+
+template <typename T>
+inline size_t vvox::PaletteContainer<T>::findRun(size_t index) const {
+    auto it = std::upper_bound(m_runs.begin(), m_runs.end(), index, [] (size_t i, const Run& r) {
+        return i < r.start;
+    });
+    return (it - m_runs.begin()) - 1;
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::mergeRuns(size_t first, size_t last) {
+    for (size_t k = last; k > first; k--) {
+        if (m_runs[k].data == m_runs[k - 1].data) m_runs.erase(m_runs.begin() + k);
+    }
+}
+
+template <typename T>
+void vvox::PaletteContainer<T>::convertToPalette() {
+    std::vector<T> buffer(m_volume);
+    uncompressIntoBuffer(buffer.data());
+    bool allowRLE = m_allowRLE;
+    m_allowRLE = false;
+    initFromBuffer(buffer.data());
+    m_allowRLE = allowRLE;
+}
@@ -43,6 +43,29 @@ namespace vorb {
                 Cardinal direction; ///< Direction the quad is facing
             };
 
+            /// Bit of a cell in a 3x3 neighbourhood mask, for offsets of -1, 0 or 1 along a face's U and V axes
+            #define VOXEL_NEIGHBOUR_BIT(U, V) (((V) + 1) * 3 + ((U) + 1))
+
+            /// Reference ambient occlusion of a face's four corners
+            /// A corner between two occluding sides is fully dark, otherwise each occluding side or
+            /// diagonal cell darkens it by one step.
+            /// @param neighbours: Occupancy of the 3x3 cells in front of the face, see VOXEL_NEIGHBOUR_BIT
+            /// @return Occlusion of corners (-U,-V), (+U,-V), (-U,+V) and (+U,+V) in 2-bit fields from the
+            /// lowest bits up, where 3 is unoccluded
+            inline ui8 computeAO(ui16 neighbours) {
+                ui8 ao = 0;
+                for (i32 corner = 0; corner < 4; corner++) {
+                    i32 u = (corner & 1) ? 1 : -1;
+                    i32 v = (corner & 2) ? 1 : -1;
+                    ui32 side1 = (neighbours >> VOXEL_NEIGHBOUR_BIT(u, 0)) & 1;
+                    ui32 side2 = (neighbours >> VOXEL_NEIGHBOUR_BIT(0, v)) & 1;
+                    ui32 diagonal = (neighbours >> VOXEL_NEIGHBOUR_BIT(u, v)) & 1;
+                    ui32 value = (side1 && side2) ? 0 : 3 - (side1 + side2 + diagonal);
+                    ao |= (ui8)(value << (corner * 2));
+                }
+                return ao;
+            }
+
             /// Create an index list for quads
             /// @tparam T: Index type/size
             /// @param quads: Number of quads for which indices must be specified
@@ -19,11 +19,14 @@
 //! @endcond
 
 #ifndef VORB_USING_PCH
+#include <vector>
+
 #include "../types.h"
 #endif // !VORB_USING_PCH
 
 #include "VoxCommon.h"
 #include "VoxelMeshAlg.h"
+#include "../ecs/BitTable.hpp"
 
 namespace vorb {
     namespace voxel {
@@ -83,6 +86,313 @@ namespace vorb {
                     }
                 }
             }
+
+            namespace impl {
+                /// Merge the visible faces of a slice into maximal rectangles
+                /// @param mask: Merge key plus one of every visible face, 0 where hidden, laid out (V, U); cleared on return
+                /// @param uSize: Width of the mask
+                /// @param vSize: Height of the mask
+                /// @param slice: Position of the slice's voxels on the face axis
+                /// @param sweep: Data axes of the face, then U and V
+                /// @param direction: Direction the faces point
+                /// @param l1: Stride of a Z step in the voxel data
+                /// @param l2: Stride of a Y step in the voxel data
+                /// @param api: API object that receives the quads
+                template<typename API>
+                inline void greedySlice(ui64* mask, ui32 uSize, ui32 vSize, ui32 slice, const ui32v3& sweep, const Cardinal& direction, const size_t& l1, const size_t& l2, API* api) {
+                    VoxelQuad q;
+                    q.direction = direction;
+                    q.voxelPosition[sweep.x] = slice;
+                    for (ui32 v = 0; v < vSize; v++) {
+                        ui64* row = mask + v * uSize;
+                        for (ui32 u = 0; u < uSize;) {
+                            ui64 key = row[u];
+                            if (!key) {
+                                u++;
+                                continue;
+                            }
+
+                            // Grow along U, then along V while every cell of the next row matches
+                            ui32 w = 1;
+                            while (u + w < uSize && row[u + w] == key) w++;
+                            ui32 h = 1;
+                            for (; v + h < vSize; h++) {
+                                const ui64* next = row + h * uSize + u;
+                                ui32 i = 0;
+                                while (i < w && next[i] == key) i++;
+                                if (i != w) break;
+                            }
+                            for (ui32 dv = 0; dv < h; dv++) {
+                                ui64* cells = row + dv * uSize + u;
+                                for (ui32 i = 0; i < w; i++) cells[i] = 0;
+                            }
+
+                            // Mask cells are offset by the padding border
+                            q.voxelPosition[sweep.y] = u + 1;
+                            q.voxelPosition[sweep.z] = v + 1;
+                            q.startIndex = (ui32)(q.voxelPosition.y * l2 + q.voxelPosition.z * l1 + q.voxelPosition.x);
+                            q.size = ui32v2(w, h);
+                            api->result(q);
+                            u += w;
+                        }
+                    }
+                }
+            }
+
+            namespace impl {
+                /// Emit a unit quad for every set bit of a row of faces along X
+                template<typename API>
+                inline void emitFaceBits(ui64 bits, ui32 y, ui32 z, const Cardinal& direction, const size_t& l1, const size_t& l2, API* api) {
+                    VoxelQuad q;
+                    q.direction = direction;
+                    q.size = ui32v2(1, 1);
+                    q.voxelPosition.y = y;
+                    q.voxelPosition.z = z;
+                    size_t rowStart = y * l2 + z * l1;
+                    for (; bits; bits &= bits - 1) {
+                        q.voxelPosition.x = vecs::impl::lowestBit64(bits);
+                        q.startIndex = (ui32)(rowStart + q.voxelPosition.x);
+                        api->result(q);
+                    }
+                }
+
+                /// Fill the occupancy of the X rows of slice y from an API that keeps its own bitmasks
+                template<typename T, typename API>
+                inline auto fillOccupancy(const T* data VORB_UNUSED, const ui32v3& size, ui32 y, ui64* rows, API* api, int) -> decltype(api->getOccupancy(y, y), void()) {
+                    for (ui32 z = 0; z < size.z; z++) rows[z] = api->getOccupancy(y, z);
+                }
+                /// Fill the occupancy of the X rows of slice y with one isOpaque call per voxel
+                template<typename T, typename API>
+                inline void fillOccupancy(const T* data, const ui32v3& size, ui32 y, ui64* rows, API* api, long) {
+                    const T* voxel = data + (size_t)y * size.x * size.z;
+                    for (ui32 z = 0; z < size.z; z++) {
+                        ui64 bits = 0;
+                        for (ui32 x = 0; x < size.x; x++, voxel++) {
+                            if (api->isOpaque(*voxel)) bits |= 1ull << x;
+                        }
+                        rows[z] = bits;
+                    }
+                }
+            }
+
+            /// Construct the same faces as createCulled from opaque occupancy bits instead of voxel pairs
+            /// Each X row becomes a 64-bit mask with one isOpaque call per voxel, then the faces of a row
+            /// are found with shifts against its neighbours and only set bits reach api->result.
+            /// An API that already keeps occupancy bitmasks can provide ui64 getOccupancy(ui32 y, ui32 z),
+            /// returning bit x set where voxel (x, y, z) is opaque, and the masks are taken from it instead
+            /// of testing voxels; data is then not read and isOpaque is not needed.
+            /// A face is visible where an opaque voxel touches a voxel that is not opaque, matching an
+            /// occludes that returns block1Face = opaque(v1) && !opaque(v2) and the reverse for block2Face.
+            /// Quads are emitted row by row, not in createCulled's order.
+            /// @pre: size.x is at most 64
+            /// @tparam T: Voxel data type
+            /// @tparam API: Type of API object providing bool isOpaque(const T& voxel) or
+            /// ui64 getOccupancy(ui32 y, ui32 z), and result(const VoxelQuad&)
+            /// @param data: 3D array of voxel data accessed Y-Z-X
+            /// @param size: Sizes of array (XYZ)
+            /// @param api: API object
+            template<typename T, typename API>
+            inline void createCulledBitmask(const T* data, const ui32v3& size, API* api) {
+                size_t l1 = size.x;
+                size_t l2 = l1 * size.z;
+
+                // Occupancy of every (Y, Z) row
+                std::vector<ui64> rows(size.y * size.z);
+                for (ui32 y = 0; y < size.y; y++) impl::fillOccupancy(data, size, y, &rows[y * size.z], api, 0);
+
+                // Only voxels off the padding border receive faces
+                ui64 interior = ((size.x >= 64) ? ~0ull : ((1ull << size.x) - 1)) & ~1ull & ~(1ull << (size.x - 1));
+                Cardinal xPos = toCardinal(Axis::X, true), xNeg = toCardinal(Axis::X, false);
+                Cardinal yPos = toCardinal(Axis::Y, true), yNeg = toCardinal(Axis::Y, false);
+                Cardinal zPos = toCardinal(Axis::Z, true), zNeg = toCardinal(Axis::Z, false);
+                for (ui32 y = 1; y < size.y - 1; y++) {
+                    for (ui32 z = 1; z < size.z - 1; z++) {
+                        const ui64* row = &rows[y * size.z + z];
+                        ui64 m = *row & interior;
+                        if (!m) continue;
+                        impl::emitFaceBits(m & ~(*row >> 1), y, z, xPos, l1, l2, api);
+                        impl::emitFaceBits(m & ~(*row << 1), y, z, xNeg, l1, l2, api);
+                        impl::emitFaceBits(m & ~row[size.z], y, z, yPos, l1, l2, api);
+                        impl::emitFaceBits(m & ~row[-(ptrdiff_t)size.z], y, z, yNeg, l1, l2, api);
+                        impl::emitFaceBits(m & ~row[1], y, z, zPos, l1, l2, api);
+                        impl::emitFaceBits(m & ~row[-1], y, z, zNeg, l1, l2, api);
+                    }
+                }
+            }
+
+            /// Construct the faces of createCulledBitmask along with the occupancy in front of each face
+            /// Occupancy bits of three Y slices are kept in a rolling cache, so every voxel is tested for
+            /// opacity once and the 3x3 neighbourhood of a face costs a few bit reads.
+            /// Each face gets the cells of the layer it faces, at offsets of -1, 0 and 1 along the (U, V)
+            /// axes of its sweep as for createGreedy, packed with VOXEL_NEIGHBOUR_BIT.
+            /// @pre: size.x is at most 64
+            /// @tparam T: Voxel data type
+            /// @tparam API: Type of API object providing bool isOpaque(const T& voxel) or
+            /// ui64 getOccupancy(ui32 y, ui32 z) as for createCulledBitmask, and
+            /// resultAO(const VoxelQuad& quad, ui16 neighbours), for which computeAO is a reference
+            /// @param data: 3D array of voxel data accessed Y-Z-X
+            /// @param size: Sizes of array (XYZ)
+            /// @param api: API object
+            template<typename T, typename API>
+            inline void createCulledAO(const T* data, const ui32v3& size, API* api) {
+                size_t l1 = size.x;
+                size_t l2 = l1 * size.z;
+
+                // Rolling occupancy of slices y - 1, y and y + 1, one word per X row
+                std::vector<ui64> cache(size.z * 3);
+                auto fillSlice = [&] (ui32 y) {
+                    impl::fillOccupancy(data, size, y, &cache[(y % 3) * size.z], api, 0);
+                };
+                auto slice = [&] (ui32 y) -> const ui64* {
+                    return &cache[(y % 3) * size.z];
+                };
+                if (size.y < 3) return;
+                fillSlice(0);
+                fillSlice(1);
+
+                ui64 interior = ((size.x >= 64) ? ~0ull : ((1ull << size.x) - 1)) & ~1ull & ~(1ull << (size.x - 1));
+                Cardinal directions[6] = {
+                    toCardinal(Axis::X, true), toCardinal(Axis::X, false),
+                    toCardinal(Axis::Y, true), toCardinal(Axis::Y, false),
+                    toCardinal(Axis::Z, true), toCardinal(Axis::Z, false)
+                };
+                VoxelQuad q;
+                q.size = ui32v2(1, 1);
+                for (ui32 y = 1; y < size.y - 1; y++) {
+                    fillSlice(y + 1);
+                    const ui64* below = slice(y - 1);
+                    const ui64* here = slice(y);
+                    const ui64* above = slice(y + 1);
+                    const ui64* layers[3] = { below, here, above };
+
+                    for (ui32 z = 1; z < size.z - 1; z++) {
+                        ui64 m = here[z] & interior;
+                        if (!m) continue;
+                        ui64 faces[6] = {
+                            m & ~(here[z] >> 1), m & ~(here[z] << 1),
+                            m & ~above[z], m & ~below[z],
+                            m & ~here[z + 1], m & ~here[z - 1]
+                        };
+
+                        q.voxelPosition.y = y;
+                        q.voxelPosition.z = z;
+                        size_t rowStart = y * l2 + z * l1;
+                        for (ui32 f = 0; f < 6; f++) {
+                            q.direction = directions[f];
+                            for (ui64 bits = faces[f]; bits; bits &= bits - 1) {
+                                ui32 x = vecs::impl::lowestBit64(bits);
+                                ui16 n = 0;
+                                switch (f >> 1) {
+                                case 0: {
+                                    // X faces: U is Z and V is Y, one bit per cell
+                                    ui32 px = (f & 1) ? x - 1 : x + 1;
+                                    for (i32 v = -1; v <= 1; v++) {
+                                        for (i32 u = -1; u <= 1; u++) {
+                                            n |= (ui16)(((layers[v + 1][z + u] >> px) & 1) << VOXEL_NEIGHBOUR_BIT(u, v));
+                                        }
+                                    }
+                                    break;
+                                }
+                                case 1: {
+                                    // Y faces: U is X and V is Z, three bits per row
+                                    const ui64* layer = (f & 1) ? below : above;
+                                    for (i32 v = -1; v <= 1; v++) n |= (ui16)(((layer[z + v] >> (x - 1)) & 7) << VOXEL_NEIGHBOUR_BIT(-1, v));
+                                    break;
+                                }
+                                default: {
+                                    // Z faces: U is X and V is Y, three bits per row
+                                    ui32 pz = (f & 1) ? z - 1 : z + 1;
+                                    for (i32 v = -1; v <= 1; v++) n |= (ui16)(((layers[v + 1][pz] >> (x - 1)) & 7) << VOXEL_NEIGHBOUR_BIT(-1, v));
+                                    break;
+                                }
+                                }
+                                q.voxelPosition.x = x;
+                                q.startIndex = (ui32)(rowStart + x);
+                                api->resultAO(q, n);
+                            }
+                        }
+                    }
+                }
+            }
+
+            /// Construct a voxel mesh like createCulled, merging coplanar faces into rectangles
+            /// Faces merge when they point the same way and the API gives their voxels the same key.
+            /// Each quad starts at its lowest voxel and its size spans (U, V) of the face's sweep,
+            /// which is (Z, Y) for X faces, (X, Z) for Y faces and (X, Y) for Z faces.
+            /// @tparam T: Voxel data type
+            /// @tparam API: Type of API object that handles culled meshing, which must also provide
+            /// ui32 mergeKey(const T& voxel, const Cardinal& direction)
+            /// @param data: 3D array of voxel data accessed Y-Z-X
+            /// @param size: Sizes of array (XYZ)
+            /// @param api: API object
+            template<typename T, typename API>
+            inline void createGreedy(const T* data, const ui32v3& size, API* api) {
+                static ui32v3 SWEEPS[3] = {
+                    ui32v3(0, 2, 1),
+                    ui32v3(1, 0, 2),
+                    ui32v3(2, 0, 1)
+                };
+                static Axis AXES[3] = {
+                    Axis::X,
+                    Axis::Y,
+                    Axis::Z
+                };
+
+                size_t l1 = size.x;
+                size_t l2 = l1 * size.z;
+
+                // One mask per direction, sized for the largest slice
+                std::vector<ui64> masks;
+                size_t maskSize = 0;
+                for (size_t axis = 0; axis < 3; axis++) {
+                    size_t u = size[SWEEPS[axis].y] - 2, v = size[SWEEPS[axis].z] - 2;
+                    if (u * v > maskSize) maskSize = u * v;
+                }
+                masks.resize(maskSize * 2);
+                ui64* maskPos = masks.data();
+                ui64* maskNeg = masks.data() + maskSize;
+
+                ui32v3 pos;
+                for (size_t axis = 0; axis < 3; axis++) {
+                    const ui32v3& sweep = SWEEPS[axis];
+                    ui32& fAxis = pos[sweep.x];
+                    ui32& uAxis = pos[sweep.y];
+                    ui32& vAxis = pos[sweep.z];
+                    ui32v3 sizes(size[sweep.x], size[sweep.y], size[sweep.z]);
+                    ui32 uSize = sizes.y - 2, vSize = sizes.z - 2;
+                    size_t fStride = (axis == 0) ? 1 : (axis == 1) ? l2 : l1;
+                    Cardinal dirPos = toCardinal(AXES[axis], true);
+                    Cardinal dirNeg = toCardinal(AXES[axis], false);
+
+                    for (fAxis = 1; fAxis < sizes.x; fAxis++) {
+                        bool anyPos = false, anyNeg = false;
+                        for (vAxis = 1; vAxis < sizes.z - 1; vAxis++) {
+                            for (uAxis = 1; uAxis < sizes.y - 1; uAxis++) {
+                                size_t i2 = pos.y * l2 + pos.z * l1 + pos.x;
+                                const T& v1 = data[i2 - fStride];
+                                const T& v2 = data[i2];
+                                size_t m = (vAxis - 1) * uSize + (uAxis - 1);
+
+                                VoxelFaces f = api->occludes(v1, v2, AXES[axis]);
+                                if (f.block1Face && fAxis != 1) {
+                                    maskPos[m] = (ui64)api->mergeKey(v1, dirPos) + 1;
+                                    anyPos = true;
+                                } else {
+                                    maskPos[m] = 0;
+                                }
+                                if (f.block2Face && fAxis != sizes.x - 1) {
+                                    maskNeg[m] = (ui64)api->mergeKey(v2, dirNeg) + 1;
+                                    anyNeg = true;
+                                } else {
+                                    maskNeg[m] = 0;
+                                }
+                            }
+                        }
+                        if (anyPos) impl::greedySlice(maskPos, uSize, vSize, fAxis - 1, sweep, dirPos, l1, l2, api);
+                        if (anyNeg) impl::greedySlice(maskNeg, uSize, vSize, fAxis, sweep, dirNeg, l1, l2, api);
+                    }
+                }
+            }
         }
     }
 }
@@ -0,0 +1,185 @@
+//
+// VoxelMipChain.h
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file VoxelMipChain.h
+ * @brief Downsampled levels of detail of voxel data, for meshing distant chunks.
+ */
+
+#pragma once
+
+#ifndef Vorb_VoxelMipChain_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_VoxelMipChain_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include <vector>
+
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include <algorithm>
+
+#include "IntervalTree.h"
+#include "../VorbAssert.hpp"
+
+#define VOXEL_MIP_SAMPLES 8 ///< Voxels reduced into one, a 2x2x2 block
+
+namespace vorb {
+    namespace voxel {
+        /// Picks the most common of the samples
+        /// Ties go to the value that appears first, so results only depend on the input.
+        template<typename T>
+        class MajorityReduction {
+        public:
+            T operator()(const T* samples) const {
+                ui32 best = 0, bestCount = 0;
+                for (ui32 i = 0; i < VOXEL_MIP_SAMPLES; i++) {
+                    // Only count a value at its first occurrence
+                    bool seen = false;
+                    for (ui32 j = 0; j < i && !seen; j++) seen = samples[j] == samples[i];
+                    if (seen) continue;
+                    ui32 count = 1;
+                    for (ui32 j = i + 1; j < VOXEL_MIP_SAMPLES; j++) {
+                        if (samples[j] == samples[i]) count++;
+                    }
+                    if (count > bestCount) {
+                        best = i;
+                        bestCount = count;
+                    }
+                }
+                return samples[best];
+            }
+        };
+
+        /// Picks the sample with the highest priority, such as keeping ores or water visible at a distance
+        /// Ties go to the sample that comes first.
+        /// @tparam F: Callable as P priority(const T&) for some comparable P
+        template<typename T, typename F>
+        class PriorityReduction {
+        public:
+            PriorityReduction(F priority) : m_priority(priority) {}
+
+            T operator()(const T* samples) const {
+                ui32 best = 0;
+                auto bestPriority = m_priority(samples[0]);
+                for (ui32 i = 1; i < VOXEL_MIP_SAMPLES; i++) {
+                    auto p = m_priority(samples[i]);
+                    if (bestPriority < p) {
+                        best = i;
+                        bestPriority = p;
+                    }
+                }
+                return samples[best];
+            }
+        private:
+            F m_priority;
+        };
+
+        /// Picks the first solid sample, scanning the top layer first so that surface voxels survive
+        /// If no sample is solid, the first one is used.
+        /// @tparam F: Callable as bool isSolid(const T&)
+        template<typename T, typename F>
+        class FirstSolidReduction {
+        public:
+            FirstSolidReduction(F isSolid) : m_isSolid(isSolid) {}
+
+            T operator()(const T* samples) const {
+                const ui32 HALF = VOXEL_MIP_SAMPLES / 2;
+                for (ui32 i = HALF; i < VOXEL_MIP_SAMPLES; i++) {
+                    if (m_isSolid(samples[i])) return samples[i];
+                }
+                for (ui32 i = 0; i < HALF; i++) {
+                    if (m_isSolid(samples[i])) return samples[i];
+                }
+                return samples[0];
+            }
+        private:
+            F m_isSolid;
+        };
+
+        /// @return Reduction by priority
+        template<typename T, typename F>
+        inline PriorityReduction<T, F> makePriorityReduction(F priority) {
+            return PriorityReduction<T, F>(priority);
+        }
+        /// @return Reduction by first solid sample
+        template<typename T, typename F>
+        inline FirstSolidReduction<T, F> makeFirstSolidReduction(F isSolid) {
+            return FirstSolidReduction<T, F>(isSolid);
+        }
+
+        /// Halve the resolution of a voxel array
+        /// @tparam R: Callable as T reduce(const T* samples), given the 8 voxels of a 2x2x2 block in Y-Z-X order
+        /// @param src: Array accessed Y-Z-X
+        /// @param size: Sizes of the source array (XYZ), each even
+        /// @param dst: Output array of size / 2 elements accessed Y-Z-X
+        /// @param reduce: Reduction of a block to one voxel
+        template<typename T, typename R>
+        void downsample(const T* src, const ui32v3& size, T* dst, R reduce);
+
+        /// Levels of detail of a voxel volume, each half the resolution of the one before
+        /// Level 0 holds the full data. A level is a dense array accessed Y-Z-X, so it may be padded with
+        /// copyPadded() and meshed like full resolution data, with quad positions and sizes scaled by 2^level.
+        /// @tparam T: Voxel data type
+        template<typename T>
+        class VoxelMipChain {
+        public:
+            /// Build levels from a voxel array
+            /// @tparam R: Callable as T reduce(const T* samples), given the 8 voxels of a 2x2x2 block in Y-Z-X order
+            /// @param data: Array accessed Y-Z-X
+            /// @param size: Sizes of the array (XYZ)
+            /// @param levels: Number of levels including the full data
+            /// @param reduce: Reduction of a block to one voxel
+            /// @pre: Each size is divisible by 2^(levels - 1)
+            template<typename R>
+            void build(const T* data, const ui32v3& size, ui32 levels, R reduce);
+            /// Build levels from a cubic chunk, decompressing it straight into level 0
+            /// @param tree: Chunk of width^3 elements accessed Y-Z-X
+            /// @param width: Width of the chunk
+            /// @param levels: Number of levels including the full data
+            /// @param reduce: Reduction of a block to one voxel
+            template<typename R>
+            void build(const IntervalTree<T>& tree, ui32 width, ui32 levels, R reduce);
+            /// Free all levels
+            void clear();
+
+            /// Write a level into the middle of a (size + 2) array, the input the meshers take
+            /// @param level: Level to copy
+            /// @param padded: Output array of getSize(level) + 2 elements accessed Y-Z-X
+            /// @param fill: Value of the border
+            void copyPadded(ui32 level, T* padded, const T& fill) const;
+
+            /// @return Number of levels
+            ui32 getLevels() const {
+                return (ui32)m_levels.size();
+            }
+            /// @return Data of a level, accessed Y-Z-X
+            const T* getLevel(ui32 level) const {
+                return m_levels[level].data();
+            }
+            /// @return Sizes of a level (XYZ)
+            const ui32v3& getSize(ui32 level) const {
+                return m_sizes[level];
+            }
+        private:
+            /// Fill every level after the first
+            template<typename R>
+            void buildLevels(ui32 levels, R& reduce);
+
+            std::vector<std::vector<T>> m_levels; ///< Voxels of each level
+            std::vector<ui32v3> m_sizes; ///< Sizes of each level
+        };
+    }
+}
+namespace vvox = vorb::voxel;
+
+#include "VoxelMipChain.inl"
+
+#endif // !Vorb_VoxelMipChain_h__
@@ -0,0 +1,74 @@
+template<typename T, typename R>
+void vvox::downsample(const T* src, const ui32v3& size, T* dst, R reduce) {
+    size_t layer = (size_t)size.x * size.z;
+    T samples[VOXEL_MIP_SAMPLES];
+    for (ui32 y = 0; y < size.y; y += 2) {
+        for (ui32 z = 0; z < size.z; z += 2) {
+            const T* row = src + y * layer + z * size.x;
+            for (ui32 x = 0; x < size.x; x += 2) {
+                const T* block = row + x;
+                samples[0] = block[0];
+                samples[1] = block[1];
+                samples[2] = block[size.x];
+                samples[3] = block[size.x + 1];
+                samples[4] = block[layer];
+                samples[5] = block[layer + 1];
+                samples[6] = block[layer + size.x];
+                samples[7] = block[layer + size.x + 1];
+                *dst++ = reduce(samples);
+            }
+        }
+    }
+}
+
+template<typename T>
+template<typename R>
+void vvox::VoxelMipChain<T>::build(const T* data, const ui32v3& size, ui32 levels, R reduce) {
+    m_levels.resize(1);
+    m_sizes.assign(1, size);
+    m_levels[0].assign(data, data + (size_t)size.x * size.y * size.z);
+    buildLevels(levels, reduce);
+}
+
+template<typename T>
+template<typename R>
+void vvox::VoxelMipChain<T>::build(const IntervalTree<T>& tree, ui32 width, ui32 levels, R reduce) {
+    m_levels.resize(1);
+    m_sizes.assign(1, ui32v3(width));
+    m_levels[0].resize((size_t)width * width * width);
+    tree.uncompressIntoBuffer(m_levels[0].data());
+    buildLevels(levels, reduce);
+}
+
+template<typename T>
+void vvox::VoxelMipChain<T>::clear() {
+    std::vector<std::vector<T>>().swap(m_levels);
+    std::vector<ui32v3>().swap(m_sizes);
+}
+
+template<typename T>
+void vvox::VoxelMipChain<T>::copyPadded(ui32 level, T* padded, const T& fill) const {
+    const ui32v3& size = m_sizes[level];
+    ui32v3 p = size + 2u;
+    std::fill_n(padded, (size_t)p.x * p.y * p.z, fill);
+    const T* src = m_levels[level].data();
+    for (ui32 y = 0; y < size.y; y++) {
+        for (ui32 z = 0; z < size.z; z++) {
+            std::copy_n(src, size.x, padded + (size_t)(y + 1) * p.x * p.z + (z + 1) * p.x + 1);
+            src += size.x;
+        }
+    }
+}
+
+template<typename T>
+template<typename R>
+void vvox::VoxelMipChain<T>::buildLevels(ui32 levels, R& reduce) {
+    for (ui32 l = 1; l < levels; l++) {
+        ui32v3 size = m_sizes[l - 1];
+        vorb_assert(size.x % 2 == 0 && size.y % 2 == 0 && size.z % 2 == 0, "Mip level sizes must be even");
+        ui32v3 half = size / 2u;
+        m_sizes.push_back(half);
+        m_levels.emplace_back((size_t)half.x * half.y * half.z);
+        downsample(m_levels[l - 1].data(), size, m_levels[l].data(), reduce);
+    }
+}
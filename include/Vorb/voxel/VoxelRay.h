@@ -0,0 +1,182 @@
+//
+// VoxelRay.h
+// Vorb Engine
+//
+// Created on 15 Oct 2026
+// Copyright 2014 Regrowth Studios
+// MIT License
+//
+
+/*! \file VoxelRay.h
+ * @brief Exact voxel traversal of rays using the Amanatides-Woo DDA.
+ */
+
+#pragma once
+
+#ifndef Vorb_VoxelRay_h__
+//! @cond DOXY_SHOW_HEADER_GUARDS
+#define Vorb_VoxelRay_h__
+//! @endcond
+
+#ifndef VORB_USING_PCH
+#include "../types.h"
+#endif // !VORB_USING_PCH
+
+#include <cmath>
+#include <limits>
+
+#include "VoxCommon.h"
+
+namespace vorb {
+    namespace voxel {
+        /// A ray in voxel space, where voxel (x, y, z) covers [x, x + 1) on each axis
+        struct VoxelRay {
+        public:
+            f64v3 origin; ///< Start of the ray
+            f64v3 direction; ///< Direction of the ray, need not be normalized
+            f64 maxDistance; ///< Length of the ray, in voxels
+        };
+
+        /// Result of a raycast
+        struct VoxelRayHit {
+        public:
+            bool hit = false; ///< True if a voxel stopped the ray
+            i32v3 voxel; ///< Voxel that stopped the ray, or the last voxel visited
+            Cardinal face = Cardinal::X_NEG; ///< Face of the voxel the ray entered through, meaningless if steps is 0
+            f64 distance = 0.0; ///< Distance from the origin to the entry point
+            ui32 steps = 0; ///< Number of voxel boundaries crossed, 0 if the ray started inside the voxel
+        };
+
+        /// Visits every voxel a ray passes through, in order, each exactly once
+        /// Each step crosses one voxel boundary, so consecutive voxels always share a face.
+        /// When the ray passes exactly through an edge or corner, the crossing happens one axis at a time.
+        class VoxelRayIterator {
+        public:
+            /// Start at the voxel that contains the origin
+            /// @param origin: Start of the ray
+            /// @param direction: Direction of the ray, need not be normalized. A zero direction only visits the first voxel.
+            /// @param maxDistance: Length of the ray, in voxels
+            VoxelRayIterator(const f64v3& origin, const f64v3& direction, f64 maxDistance) :
+                m_maxDistance(maxDistance) {
+                f64 length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+                for (i32 i = 0; i < 3; i++) {
+                    f64 floored = std::floor(origin[i]);
+                    m_voxel[i] = (i32)floored;
+                    f64 d = length > 0.0 ? direction[i] / length : 0.0;
+                    if (d > 0.0) {
+                        m_step[i] = 1;
+                        m_tDelta[i] = 1.0 / d;
+                        m_tMax[i] = (floored + 1.0 - origin[i]) * m_tDelta[i];
+                    } else if (d < 0.0) {
+                        m_step[i] = -1;
+                        m_tDelta[i] = -1.0 / d;
+                        m_tMax[i] = (origin[i] - floored) * m_tDelta[i];
+                    } else {
+                        m_step[i] = 0;
+                        m_tDelta[i] = std::numeric_limits<f64>::infinity();
+                        m_tMax[i] = std::numeric_limits<f64>::infinity();
+                    }
+                }
+            }
+
+            /// Move to the next voxel along the ray
+            /// @return False once the next boundary lies beyond the maximum distance, leaving the current voxel unchanged
+            bool next() {
+                i32 axis = (m_tMax.x <= m_tMax.y) ? ((m_tMax.x <= m_tMax.z) ? 0 : 2) : ((m_tMax.y <= m_tMax.z) ? 1 : 2);
+                f64 t = m_tMax[axis];
+                if (t > m_maxDistance) return false;
+                m_voxel[axis] += m_step[axis];
+                m_distance = t;
+                m_tMax[axis] += m_tDelta[axis];
+                // Moving in the positive direction enters through the negative face
+                m_face = toCardinal((Axis)axis, m_step[axis] < 0);
+                m_steps++;
+                return true;
+            }
+
+            /// @return Current voxel
+            const i32v3& getVoxel() const {
+                return m_voxel;
+            }
+            /// @return Face the current voxel was entered through, meaningless before the first step
+            const Cardinal& getFace() const {
+                return m_face;
+            }
+            /// @return Distance from the origin to where the current voxel was entered
+            const f64& getDistance() const {
+                return m_distance;
+            }
+            /// @return Number of steps taken
+            const ui32& getSteps() const {
+                return m_steps;
+            }
+        private:
+            i32v3 m_voxel; ///< Current voxel
+            i32v3 m_step; ///< Direction of a step on each axis, or 0
+            f64v3 m_tMax; ///< Distance to the next boundary on each axis
+            f64v3 m_tDelta; ///< Distance between boundaries on each axis
+            f64 m_maxDistance; ///< Length of the ray
+            f64 m_distance = 0.0; ///< Distance to the entry of the current voxel
+            Cardinal m_face = Cardinal::X_NEG; ///< Entry face of the current voxel
+            ui32 m_steps = 0; ///< Boundaries crossed
+        };
+
+        /// Walk a ray until a callback stops it
+        /// @tparam F: Callable as bool f(const i32v3& voxel, const Cardinal& face, f64 distance, ui32 steps), returning true to stop
+        /// @param ray: Ray to walk
+        /// @param f: Called for every voxel along the ray, starting with the one containing the origin
+        /// @return True if the callback stopped the walk
+        template<typename F>
+        inline bool traceRay(const VoxelRay& ray, F f) {
+            VoxelRayIterator it(ray.origin, ray.direction, ray.maxDistance);
+            do {
+                if (f(it.getVoxel(), it.getFace(), it.getDistance(), it.getSteps())) return true;
+            } while (it.next());
+            return false;
+        }
+
+        /// Find the first solid voxel along a ray
+        /// @tparam F: Callable as bool isSolid(const i32v3& voxel)
+        /// @param ray: Ray to cast
+        /// @param isSolid: Voxel query
+        /// @return The first solid voxel, including the one containing the origin, or the last voxel visited
+        template<typename F>
+        inline VoxelRayHit raycast(const VoxelRay& ray, F isSolid) {
+            VoxelRayHit result;
+            VoxelRayIterator it(ray.origin, ray.direction, ray.maxDistance);
+            do {
+                if (isSolid(it.getVoxel())) {
+                    result.hit = true;
+                    break;
+                }
+            } while (it.next());
+            result.voxel = it.getVoxel();
+            result.face = it.getFace();
+            result.distance = it.getDistance();
+            result.steps = it.getSteps();
+            return result;
+        }
+
+        /// Cast many rays against the same voxels, such as visibility checks for a group of agents
+        /// Rays are independent, so a large batch may also be split over vcore::parallelFor chunks,
+        /// provided the query is safe to call from several threads.
+        /// @tparam F: Callable as bool isSolid(const i32v3& voxel)
+        /// @param rays: Array of rays
+        /// @param count: Number of rays
+        /// @param isSolid: Voxel query
+        /// @param hits: Output array of count results
+        /// @return Number of rays that hit a solid voxel
+        template<typename F>
+        inline size_t raycastMany(const VoxelRay* rays, size_t count, F isSolid, VoxelRayHit* hits) {
+            size_t numHits = 0;
+            for (size_t i = 0; i < count; i++) {
+                hits[i] = raycast(rays[i], isSolid);
+                if (hits[i].hit) numHits++;
+            }
+            return numHits;
+        }
+    }
+}
+namespace vvox = vorb::voxel;
+
+#endif // !Vorb_VoxelRay_h__
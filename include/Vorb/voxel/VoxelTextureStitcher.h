@@ -31,11 +31,21 @@ class BlockAtlasPage;
 */
 namespace vorb {
     namespace voxel {
+        /// Occupancy statistics of an atlas
+        struct AtlasStats {
+        public:
+            size_t pages; ///< Number of allocated pages
+            size_t usedTiles; ///< Number of mapped tiles, including the null texture
+            size_t totalTiles; ///< Number of tiles in all pages
+            f32 fillRatio; ///< Used tiles divided by total tiles
+        };
+
         class VoxelTextureStitcher {
         public:
             /*! @brief Constructor
             *
             * Allocates a single page and maps a null texture index
+            * @param tilesPerRow: Width and height of a page in tiles
             */
             VoxelTextureStitcher(ui32 tilesPerRow = 16u);
             /*! @brief Necessary destructor to free allocated pages
@@ -66,16 +76,38 @@ namespace vorb {
             const ui32& getTilesPerRow() const { return m_tilesPerRow; }
             const ui32& getTilesPerPage() const { return m_tilesPerPage; }
 
+            /// @param index: Index into the atlas array
+            /// @return True if the tile is mapped
+            bool isMapped(ui32 index) const;
+            /// @return Occupancy of all pages
+            AtlasStats getStats() const;
+
             void dispose();
         private:
             VORB_NON_COPYABLE(VoxelTextureStitcher);
+
+            /// Occupancy of a page
+            struct Page {
+                std::vector<ui64> bits; ///< One bit per tile, row-major
+                std::vector<ui32v2> boxFails; ///< Smallest box sizes that did not fit
+                ui32 used = 0; ///< Number of mapped tiles
+            };
+
             void addPage();
+            /// @return Page holding an atlas index, allocating pages up to it
+            Page& getPage(ui32 pageIndex);
+            /// Mark count tiles starting at a page tile as mapped
+            void markRange(Page& page, ui32 start, ui32 count);
+            /// @return First used tile of a page in [from, limit), or limit
+            ui32 findUsed(const Page& page, ui32 from, ui32 limit) const;
+            /// @return First free tile of a page at or after from, or m_tilesPerPage
+            ui32 findFree(const Page& page, ui32 from) const;
 
-            // TODO(Ben): Bitfield for smaller mem usage
-            std::vector<bool*> m_pages; ///< list of pages. A page is just an array of bools.
+            std::vector<Page> m_pages; ///< list of pages
             ui32 m_oldestFreeSlot; ///< The left-most free slot in the atlas array
             ui32 m_tilesPerRow;
             ui32 m_tilesPerPage;
+            ui32 m_pageWords; ///< Number of occupancy words of a page
         };
     }
 }
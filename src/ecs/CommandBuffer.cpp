@@ -0,0 +1,98 @@
+#include "Vorb/stdafx.h"
+#include "Vorb/ecs/CommandBuffer.h"
+
+#include <algorithm>
+
+#include "Vorb/ecs/ECS.h"
+
+vecs::EntityID vecs::CommandBuffer::createEntity() {
+    m_createKeys.push_back(m_sortKey);
+    return COMMAND_BUFFER_PLACEHOLDER_BIT | (ui32)(m_createKeys.size() - 1);
+}
+void vecs::CommandBuffer::destroyEntity(EntityID eID) {
+    m_destroyed.push_back(eID);
+}
+void vecs::CommandBuffer::addComponent(TableID tableID, EntityID eID) {
+    record(CommandType::ADD_COMPONENT, tableID, eID, nullptr);
+}
+void vecs::CommandBuffer::removeComponent(TableID tableID, EntityID eID) {
+    record(CommandType::REMOVE_COMPONENT, tableID, eID, nullptr);
+}
+
+void vecs::CommandBuffer::record(CommandType type, TableID tableID, EntityID eID, Payload* payload) {
+    Command cmd;
+    cmd.sortKey = m_sortKey;
+    cmd.type = type;
+    cmd.table = tableID;
+    cmd.entity = eID;
+    cmd.payload = payload;
+    m_commands.push_back(cmd);
+}
+
+void vecs::CommandBuffer::clear() {
+    m_sortKey = 0;
+    m_createKeys.clear();
+    m_commands.clear();
+    m_destroyed.clear();
+    m_payloads.clear();
+}
+
+void vecs::CommandBuffer::playback(ECS& ecs, CommandBuffer* const* buffers, size_t n) {
+    // Everything is merged through a stable sort, which keeps buffer and recording order for equal keys
+    struct Entry {
+        ui32 sortKey;
+        ui32 index;
+        CommandBuffer* buffer;
+    };
+    auto compare = [] (const Entry& a, const Entry& b) {
+        return a.sortKey < b.sortKey;
+    };
+    std::vector<Entry> entries;
+
+    // Create every entity in one batch
+    for (size_t b = 0; b < n; b++) {
+        CommandBuffer* buffer = buffers[b];
+        for (size_t i = 0; i < buffer->m_createKeys.size(); i++) entries.push_back({ buffer->m_createKeys[i], (ui32)i, buffer });
+        buffer->m_created.resize(buffer->m_createKeys.size());
+    }
+    std::stable_sort(entries.begin(), entries.end(), compare);
+    std::vector<EntityID> ids(entries.size());
+    ecs.addEntities(ids.size(), ids.data());
+    for (size_t i = 0; i < entries.size(); i++) entries[i].buffer->m_created[entries[i].index] = ids[i];
+
+    // Component changes
+    entries.clear();
+    for (size_t b = 0; b < n; b++) {
+        CommandBuffer* buffer = buffers[b];
+        for (size_t i = 0; i < buffer->m_commands.size(); i++) entries.push_back({ buffer->m_commands[i].sortKey, (ui32)i, buffer });
+    }
+    std::stable_sort(entries.begin(), entries.end(), compare);
+
+    const EntitySet& alive = ecs.getEntities();
+    for (auto& entry : entries) {
+        const Command& cmd = entry.buffer->m_commands[entry.index];
+        EntityID eID = entry.buffer->resolve(cmd.entity);
+        // The entity may have been destroyed before playback
+        if (alive.find(eID) == alive.end()) continue;
+
+        if (cmd.type == CommandType::ADD_COMPONENT) {
+            ComponentID cID;
+            if (ecs.addComponents(cmd.table, &eID, 1, &cID) && cmd.payload) {
+                cmd.payload->apply(ecs.getComponentTable(cmd.table), cID);
+            }
+        } else {
+            ecs.deleteComponent(cmd.table, eID);
+        }
+    }
+
+    // Destroy last so that earlier commands never see a recycled ID
+    std::vector<EntityID> destroyed;
+    for (size_t b = 0; b < n; b++) {
+        for (auto& eID : buffers[b]->m_destroyed) destroyed.push_back(buffers[b]->resolve(eID));
+    }
+    std::sort(destroyed.begin(), destroyed.end());
+    destroyed.erase(std::unique(destroyed.begin(), destroyed.end()), destroyed.end());
+    ecs.deleteEntities(destroyed.data(), destroyed.size());
+
+    for (size_t b = 0; b < n; b++) buffers[b]->clear();
+}
@@ -1,30 +1,41 @@
 #include "Vorb/stdafx.h"
 #include "Vorb/ecs/ComponentTableBase.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 #include "Vorb/ecs/ECS.h"
 
-vecs::ComponentTableBase::ComponentTableBase() :
+vecs::ComponentTableBase::ComponentTableBase(ComponentStorage storage /*= ComponentStorage::STABLE*/) :
     onEntityAdded(this),
-    onEntityRemoved(this) {
+    onEntityRemoved(this),
+    m_storage(storage) {
     // Empty
 }
 
 vecs::ComponentID vecs::ComponentTableBase::add(EntityID eID) {
     // Check that this entity does not exist
-    auto cBind = _components.find(eID);
-    if (cBind != _components.end()) {
+    ui32 i = m_entityIndex.get(eID);
+    if (i != 0) {
         char buf[256];
         sprintf(buf,
                 "Entity <0x%08lX> already contains component <0x%08lX>",
                 static_cast<unsigned long>(eID),
-                static_cast<unsigned long>(cBind->second));
+                static_cast<unsigned long>(_components[i - 1].second));
         throw std::runtime_error(buf);
     }
 
     // Generate a new component
-    bool shouldPush = false;
-    ComponentID id = _genComponent.generate(&shouldPush);
-    _components[eID] = id;
+    bool shouldPush = true;
+    ComponentID id;
+    if (m_storage == ComponentStorage::PACKED) {
+        // Packed components always go at the end
+        id = (ComponentID)_components.size() + 1;
+    } else {
+        id = _genComponent.generate(&shouldPush);
+    }
+    _components.emplace_back(eID, id);
+    m_entityIndex.set(eID, (ui32)_components.size());
 
     if (shouldPush) {
         // Add a new component
@@ -42,28 +53,52 @@ vecs::ComponentID vecs::ComponentTableBase::add(EntityID eID) {
 
     return id;
 }
+void vecs::ComponentTableBase::reserve(size_t n) {
+    // Keep geometric growth so that many small batches don't reallocate every time
+    size_t needed = _components.size() + n;
+    if (needed > _components.capacity()) _components.reserve(std::max(needed, _components.capacity() * 2));
+    reserveComponents(n);
+}
 bool vecs::ComponentTableBase::remove(EntityID eID) {
     // Find the entity
-    auto cBind = _components.find(eID);
-    if (cBind == _components.end()) return false;
+    ui32 i = m_entityIndex.get(eID);
+    if (i == 0) return false;
+    ComponentID id = _components[i - 1].second;
 
     // Signal removal
-    onEntityRemoved(cBind->second, eID);
+    onEntityRemoved(id, eID);
 
     // Perform disposal operations
-    disposeComponent(cBind->second, eID);
+    disposeComponent(id, eID);
 
     // Component is cleared
-    _genComponent.recycle(cBind->second);
-    setComponent(cBind->second, ID_GENERATOR_NULL_ID);
-    _components.erase(cBind);
+    if (m_storage == ComponentStorage::PACKED) {
+        moveComponent((ComponentID)_components.size(), id);
+    } else {
+        _genComponent.recycle(id);
+        setComponent(id, ID_GENERATOR_NULL_ID);
+    }
+
+    // Fill the hole with the last pairing
+    ComponentBinding& last = _components.back();
+    if (i != _components.size()) {
+        _components[i - 1].first = last.first;
+        // A packed component was moved into the removed slot along with its pairing
+        if (m_storage != ComponentStorage::PACKED) _components[i - 1].second = last.second;
+        m_entityIndex.set(last.first, i);
+    }
+    _components.pop_back();
+    m_entityIndex.set(eID, 0);
 
     return true;
 }
 
 void vecs::ComponentTableBase::unsafeSetSize(size_t n) {
+    if (m_storage == ComponentStorage::PACKED) throw std::runtime_error("Unsafe component linking requires stable storage");
+
     { // Remove old components
-        std::vector<vecs::EntityID> entities(getComponentCount());
+        std::vector<vecs::EntityID> entities;
+        entities.reserve(getComponentCount());
         for (auto& ec : _components) entities.emplace_back(ec.first);
         for (auto& e : entities) remove(e);
         _genComponent.reset();
@@ -79,12 +114,15 @@ void vecs::ComponentTableBase::unsafeSetSize(size_t n) {
 }
 
 void vecs::ComponentTableBase::unsafeSetLink(vecs::ECS& ecs, vecs::EntityID eID, vecs::ComponentID cID) {
+    if (m_storage == ComponentStorage::PACKED) throw std::runtime_error("Unsafe component linking requires stable storage");
+
     if (eID == 0) {
         // Recycle ID
         _genComponent.recycle(cID);
     } else {
         // Setup component
-        _components[eID] = cID;
+        _components.emplace_back(eID, cID);
+        m_entityIndex.set(eID, (ui32)_components.size());
         setComponent(cID, eID);
         initComponent(cID, eID);
         onEntityAdded(cID, eID);
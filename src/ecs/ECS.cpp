@@ -1,28 +1,25 @@
 #include "Vorb/stdafx.h"
 #include "Vorb/ecs/ECS.h"
 
+#include <algorithm>
+
 #include "Vorb/ecs/ComponentTableBase.h"
 
 vecs::ECS::ECS() :
     onEntityAdded(this),
     onEntityRemoved(this),
+    onEntitiesAdded(this),
+    onEntitiesRemoved(this),
     onComponentAdded(this) {
     // Empty
 }
 
 vecs::EntityID vecs::ECS::addEntity() {
     // Generate a new entity
-    EntityID id = m_genEntity.generate();
+    EntityID id = (EntityID)m_genEntity.generate().getIndex();
     m_entities.emplace(id);
 
-    // Check for bit-table insertion
-    if (id > m_eidHighest) {
-        m_entityComponents.addRows(id - m_eidHighest);
-        m_eidHighest = id;
-    } else {
-        // Erase previous entity's component values (why?)
-        m_entityComponents.setRowFalse(id - 1);
-    }
+    prepareRow(id);
 
     // Signal a newly created entity
     onEntityAdded(id);
@@ -37,21 +34,83 @@ bool vecs::ECS::deleteEntity(EntityID id) {
 
     // Recycle the ID
     m_entities.erase(entity);
-    m_genEntity.recycle(id);
+    m_genEntity.recycle(m_genEntity.getHandle(id));
 
     // Signal an entity must be destroyed
     onEntityRemoved(id);
 
     // Remove all the components that this entity has
     vecs::BitArray components = m_entityComponents.getRow(id - 1);
-    for (TableID c = m_entityComponents.getBitColumnCount(); c > 0;) {
-        c--;
-        if (components.valueOf(c)) m_componentList[c]->remove(id);
+    for (TableID c = components.findNextSet(0); c < m_entityComponents.getBitColumnCount(); c = components.findNextSet(c + 1)) {
+        m_componentList[c]->remove(id);
     }
+    m_entityComponents.setRowFalse(id - 1);
 
     return true;
 }
 
+void vecs::ECS::addEntities(size_t n, EntityID* ids) {
+    if (n == 0) return;
+    m_entities.reserve(m_entities.size() + n);
+
+    EntityID highest = m_eidHighest;
+    for (size_t i = 0; i < n; i++) {
+        ids[i] = (EntityID)m_genEntity.generate().getIndex();
+        m_entities.emplace(ids[i]);
+        if (ids[i] > highest) highest = ids[i];
+    }
+
+    // Grow the bit-table once for the whole batch
+    if (highest > m_eidHighest) {
+        m_entityComponents.addRows(highest - m_eidHighest);
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (ids[i] <= m_eidHighest) m_entityComponents.setRowFalse(ids[i] - 1);
+    }
+    m_eidHighest = highest;
+
+    // Signal the new entities
+    onEntitiesAdded(ids, n);
+}
+size_t vecs::ECS::deleteEntities(const EntityID* ids, size_t n) {
+    // Recycle the IDs that exist
+    std::vector<EntityID> deleted;
+    deleted.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        auto entity = m_entities.find(ids[i]);
+        if (entity == m_entities.end()) continue;
+        m_entities.erase(entity);
+        m_genEntity.recycle(m_genEntity.getHandle(ids[i]));
+        deleted.push_back(ids[i]);
+    }
+    if (deleted.empty()) return 0;
+
+    // Signal the entities must be destroyed
+    onEntitiesRemoved(deleted.data(), deleted.size());
+
+    // Remove all the components that these entities have
+    for (auto& id : deleted) {
+        vecs::BitArray components = m_entityComponents.getRow(id - 1);
+        for (TableID c = components.findNextSet(0); c < m_entityComponents.getBitColumnCount(); c = components.findNextSet(c + 1)) {
+            m_componentList[c]->remove(id);
+        }
+        m_entityComponents.setRowFalse(id - 1);
+    }
+
+    return deleted.size();
+}
+
+void vecs::ECS::prepareRow(EntityID id) {
+    // Check for bit-table insertion
+    if (id > m_eidHighest) {
+        m_entityComponents.addRows(id - m_eidHighest);
+        m_eidHighest = id;
+    } else {
+        // Erase previous entity's component values (why?)
+        m_entityComponents.setRowFalse(id - 1);
+    }
+}
+
 vecs::TableID vecs::ECS::addComponentTable(nString name, vecs::ComponentTableBase* table) {
     TableID id = (TableID)m_componentList.size() + 1;
     table->m_id = id;
@@ -86,13 +145,57 @@ vecs::ComponentID vecs::ECS::addComponent(nString name, EntityID id) {
     m_entityComponents.setTrue(id - 1, table->getID() - 1);
     return table->add(id);
 }
+size_t vecs::ECS::addComponents(TableID tableID, const EntityID* ids, size_t n, OPT ComponentID* cIDs /*= nullptr*/) {
+    ComponentTableBase* table = getComponentTable(tableID);
+    table->reserve(n);
+
+    std::vector<EntityID> added;
+    added.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        // Can't have multiple of the same component
+        ComponentID cID = ID_GENERATOR_NULL_ID;
+        if (!hasComponent(tableID, ids[i])) {
+            m_entityComponents.setTrue(ids[i] - 1, tableID - 1);
+            cID = table->add(ids[i]);
+            added.push_back(ids[i]);
+        }
+        if (cIDs) cIDs[i] = cID;
+    }
+    if (added.empty()) return 0;
+
+    // Signal the components were added
+    onComponentsAdded(tableID, added.data(), added.size());
+
+    return added.size();
+}
 bool vecs::ECS::deleteComponent(nString name, EntityID id) {
-    ComponentTableBase* table = getComponentTable(name);
-    if (!table) return false;
-    if (!hasComponent(table->getID(), id)) return false;
+    TableID tid = getComponentTableID(name);
+    if (tid == 0) return false;
+    return deleteComponent(tid, id);
+}
+bool vecs::ECS::deleteComponent(TableID tableID, EntityID id) {
+    if (!hasComponent(tableID, id)) return false;
     // TODO: Delete component dependencies
-    m_entityComponents.setFalse(id - 1, table->getID() - 1);
-    return table->remove(id);
+    m_entityComponents.setFalse(id - 1, tableID - 1);
+    return getComponentTable(tableID)->remove(id);
+}
+
+void vecs::ECS::queryEntities(const std::vector<TableID>& all, const std::vector<TableID>& none, std::vector<EntityID>& entities) const {
+    // Table IDs and entity IDs are both offset by one from the bit table
+    std::vector<ui32> columns(all.size() + none.size());
+    for (size_t i = 0; i < all.size(); i++) columns[i] = all[i] - 1;
+    for (size_t i = 0; i < none.size(); i++) columns[all.size() + i] = none[i] - 1;
+
+    size_t first = entities.size();
+    m_entityComponents.queryRows(columns.data(), all.size(), columns.data() + all.size(), none.size(), entities);
+    for (size_t i = first; i < entities.size(); i++) entities[i]++;
+
+    // Rows of dead entities are empty, which only matters when nothing is required
+    if (all.empty()) {
+        entities.erase(std::remove_if(entities.begin() + first, entities.end(), [&] (EntityID e) {
+            return m_entities.find(e) == m_entities.end();
+        }), entities.end());
+    }
 }
 
 bool vecs::ECS::hasComponent(const TableID& tableID, const EntityID& id) const {
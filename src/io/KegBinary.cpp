@@ -0,0 +1,389 @@
+#include "Vorb/stdafx.h"
+#include "Vorb/io/Keg.h"
+
+#include <unordered_set>
+
+#include "Vorb/io/YAML.h"
+#include "Vorb/io/KegFuncs.h"
+
+#define KEG_BINARY_MAGIC 0x4247454Bu ///< "KEGB" as a little-endian ui32
+#define KEG_BINARY_NULL_STRING 0xFFFFFFFFu ///< Length written for a null C string
+
+namespace keg {
+    // Byte Size Of Each Numeric Component, Indexed By BasicType / 4
+    const size_t BINARY_NUM_SIZES[] = { 1, 2, 4, 8, 1, 2, 4, 8, 4, 8 };
+
+    // Find The Type Of Array Elements Or Pointed-To Values The Same Way The YAML Reader Does
+    Type* getBinaryInteriorType(const Value* decl, Environment* env) {
+        nString typeName = decl->typeName;
+        if (typeName.empty() && decl->interiorValue) {
+            auto kvp = basicTypes.find(decl->interiorValue->type);
+            if (kvp != basicTypes.end()) typeName = kvp->second;
+            else typeName = decl->interiorValue->typeName;
+        }
+        return typeName.empty() ? nullptr : env->getType(typeName);
+    }
+
+    // Custom Values With Their Own Evaluator Are Stored As YAML Text
+    inline bool isTextValue(const Value* decl) {
+        return decl->type == BasicType::CUSTOM && decl->evaluator;
+    }
+
+    class BinaryHasher {
+    public:
+        BinaryHasher(Environment* env) :
+            m_env(env) {
+            // Empty
+        }
+
+        void add(const void* data, size_t size) {
+            const ui8* bytes = (const ui8*)data;
+            for (size_t i = 0; i < size; i++) {
+                m_hash ^= bytes[i];
+                m_hash *= 1099511628211ull;
+            }
+        }
+        template<typename T>
+        void add(const T& value) {
+            add(&value, sizeof(T));
+        }
+        void add(const nString& s) {
+            add((ui32)s.size());
+            add(s.data(), s.size());
+        }
+
+        void addType(Type* type) {
+            // Types after their first appearance only mark their place, which also ends recursion
+            if (!m_visited.insert(type).second) {
+                add((ui8)0xFF);
+                return;
+            }
+            add((ui64)type->getSizeInBytes());
+            for (auto iter = type->getIter(); iter != type->getIterEnd(); iter++) {
+                add(iter->first);
+                addValue(&iter->second);
+            }
+            add((ui8)0xFE);
+        }
+        void addValue(const Value* decl) {
+            add((ui32)decl->type);
+            add((ui64)decl->offset);
+            add(decl->typeName);
+            switch (decl->type) {
+            case BasicType::ENUM:
+                if (Enum* e = m_env->getEnum(decl->typeName)) {
+                    add((ui64)e->getSizeInBytes());
+                    for (auto iter = e->getIter(); iter != e->getIterEnd(); iter++) {
+                        add(iter->first);
+                        add(iter->second);
+                    }
+                }
+                break;
+            case BasicType::CUSTOM:
+                if (isTextValue(decl)) break;
+                if (Type* type = m_env->getType(decl->typeName)) addType(type);
+                break;
+            case BasicType::ARRAY:
+            case BasicType::PTR:
+                if (Type* type = getBinaryInteriorType(decl, m_env)) add((ui64)type->getSizeInBytes());
+                if (decl->interiorValue) addValue(decl->interiorValue.get());
+                break;
+            default:
+                break;
+            }
+        }
+
+        ui64 getHash() const {
+            return m_hash;
+        }
+    private:
+        Environment* m_env;
+        ui64 m_hash = 14695981039346656037ull;
+        std::unordered_set<Type*> m_visited;
+    };
+
+    class BinaryWriter {
+    public:
+        BinaryWriter(std::vector<ui8>& out, Environment* env) :
+            m_out(out),
+            m_env(env) {
+            // Empty
+        }
+
+        void put(const void* data, size_t size) {
+            const ui8* bytes = (const ui8*)data;
+            m_out.insert(m_out.end(), bytes, bytes + size);
+        }
+        template<typename T>
+        void put(const T& value) {
+            put(&value, sizeof(T));
+        }
+        void putString(const char* s, size_t length) {
+            put((ui32)length);
+            put(s, length);
+        }
+
+        bool writeType(const ui8* src, Type* type) {
+            for (auto iter = type->getIter(); iter != type->getIterEnd(); iter++) {
+                if (!writeValue(src + iter->second.offset, &iter->second)) return false;
+            }
+            return true;
+        }
+        bool writeValue(const ui8* src, const Value* decl) {
+            switch (decl->type) {
+            case BasicType::BOOL:
+                put((ui8)(*(const bool*)src ? 1 : 0));
+                return true;
+            case BasicType::STRING: {
+                const nString& s = *(const nString*)src;
+                putString(s.data(), s.size());
+                return true;
+            }
+            case BasicType::C_STRING: {
+                const char* s = *(const cString*)src;
+                if (s) putString(s, strlen(s));
+                else put((ui32)KEG_BINARY_NULL_STRING);
+                return true;
+            }
+            case BasicType::ENUM: {
+                Enum* e = m_env->getEnum(decl->typeName);
+                if (e == nullptr) return false;
+                put(src, e->getSizeInBytes());
+                return true;
+            }
+            case BasicType::CUSTOM: {
+                if (isTextValue(decl)) {
+                    if (!decl->outputter) return false;
+                    keg::YAMLWriter writer;
+                    decl->outputter(writer, src);
+                    const char* text = writer.c_str();
+                    putString(text, strlen(text));
+                    return true;
+                }
+                Type* type = m_env->getType(decl->typeName);
+                if (type == nullptr) return false;
+                return writeType(src, type);
+            }
+            case BasicType::ARRAY: {
+                const ArrayBase& arr = *(const ArrayBase*)src;
+                Type* type = getBinaryInteriorType(decl, m_env);
+                if (type == nullptr || !decl->interiorValue) return false;
+                put((ui32)arr.size());
+                for (size_t i = 0; i < arr.size(); i++) {
+                    if (!writeValue(&arr.at<ui8>(0) + i * type->getSizeInBytes(), decl->interiorValue.get())) return false;
+                }
+                return true;
+            }
+            case BasicType::PTR: {
+                const ui8* ptr = *(const ui8* const*)src;
+                put((ui8)(ptr ? 1 : 0));
+                if (ptr == nullptr) return true;
+                if (!decl->interiorValue) return false;
+                return writeValue(ptr, decl->interiorValue.get());
+            }
+            default:
+                if (decl->type >= BasicType::BOOL) return false;
+                put(src, BINARY_NUM_SIZES[(size_t)decl->type / 4] * ((size_t)decl->type % 4 + 1));
+                return true;
+            }
+        }
+    private:
+        std::vector<ui8>& m_out;
+        Environment* m_env;
+    };
+
+    class BinaryReader {
+    public:
+        BinaryReader(const ui8* data, size_t size, Environment* env) :
+            m_data(data),
+            m_end(data + size),
+            m_env(env) {
+            // Empty
+        }
+
+        bool get(void* dest, size_t size) {
+            if ((size_t)(m_end - m_data) < size) return false;
+            memcpy(dest, m_data, size);
+            m_data += size;
+            return true;
+        }
+        template<typename T>
+        bool get(T& value) {
+            return get(&value, sizeof(T));
+        }
+        bool getString(const char*& s, ui32& length) {
+            if (!get(length)) return false;
+            if (length == KEG_BINARY_NULL_STRING) return true;
+            if ((size_t)(m_end - m_data) < length) return false;
+            s = (const char*)m_data;
+            m_data += length;
+            return true;
+        }
+
+        Error readType(ui8* dest, Type* type) {
+            for (auto iter = type->getIter(); iter != type->getIterEnd(); iter++) {
+                Error err = readValue(dest + iter->second.offset, &iter->second);
+                if (err != Error::NONE) return err;
+            }
+            return Error::NONE;
+        }
+        Error readValue(ui8* dest, const Value* decl) {
+            switch (decl->type) {
+            case BasicType::BOOL: {
+                ui8 b;
+                if (!get(b)) return Error::EARLY_EOF;
+                *(bool*)dest = b != 0;
+                return Error::NONE;
+            }
+            case BasicType::STRING: {
+                const char* s = nullptr;
+                ui32 length;
+                if (!getString(s, length) || length == KEG_BINARY_NULL_STRING) return Error::EARLY_EOF;
+                ((nString*)dest)->assign(s, length);
+                return Error::NONE;
+            }
+            case BasicType::C_STRING: {
+                const char* s = nullptr;
+                ui32 length;
+                if (!getString(s, length)) return Error::EARLY_EOF;
+                if (length == KEG_BINARY_NULL_STRING) {
+                    *(cString*)dest = nullptr;
+                } else {
+                    cString copy = new char[length + 1];
+                    memcpy(copy, s, length);
+                    copy[length] = 0;
+                    *(cString*)dest = copy;
+                }
+                return Error::NONE;
+            }
+            case BasicType::ENUM: {
+                Enum* e = m_env->getEnum(decl->typeName);
+                if (e == nullptr) return Error::TYPE_NOT_FOUND;
+                return get(dest, e->getSizeInBytes()) ? Error::NONE : Error::EARLY_EOF;
+            }
+            case BasicType::CUSTOM: {
+                if (isTextValue(decl)) {
+                    const char* s = nullptr;
+                    ui32 length;
+                    if (!getString(s, length) || length == KEG_BINARY_NULL_STRING) return Error::EARLY_EOF;
+                    nString text(s, length);
+                    YAMLReader reader;
+                    reader.init(text.c_str());
+                    decl->evaluator(dest, reader.getFirst());
+                    reader.dispose();
+                    return Error::NONE;
+                }
+                Type* type = m_env->getType(decl->typeName);
+                if (type == nullptr) return Error::TYPE_NOT_FOUND;
+                return readType(dest, type);
+            }
+            case BasicType::ARRAY: {
+                Type* type = getBinaryInteriorType(decl, m_env);
+                if (type == nullptr || !decl->interiorValue) return Error::TYPE_NOT_FOUND;
+                ui32 count;
+                if (!get(count)) return Error::EARLY_EOF;
+                ArrayBase* arr = new (dest) ArrayBase(type->getSizeInBytes());
+                if (count == 0) return Error::NONE;
+                arr->ownData(type->allocArray(count), count, type->getDeallocator());
+                ui8* element = &arr->at<ui8>(0);
+                for (ui32 i = 0; i < count; i++) {
+                    Error err = readValue(element, decl->interiorValue.get());
+                    if (err != Error::NONE) return err;
+                    element += type->getSizeInBytes();
+                }
+                return Error::NONE;
+            }
+            case BasicType::PTR: {
+                ui8 present;
+                if (!get(present)) return Error::EARLY_EOF;
+                *(void**)dest = nullptr;
+                if (!present) return Error::NONE;
+                Type* type = getBinaryInteriorType(decl, m_env);
+                if (type == nullptr || !decl->interiorValue) return Error::TYPE_NOT_FOUND;
+                *(void**)dest = type->alloc();
+                return readValue((ui8*)*(void**)dest, decl->interiorValue.get());
+            }
+            default:
+                if (decl->type >= BasicType::BOOL) return Error::BAD_VALUE;
+                return get(dest, BINARY_NUM_SIZES[(size_t)decl->type / 4] * ((size_t)decl->type % 4 + 1)) ? Error::NONE : Error::EARLY_EOF;
+            }
+        }
+
+        bool isAtEnd() const {
+            return m_data == m_end;
+        }
+    private:
+        const ui8* m_data;
+        const ui8* m_end;
+        Environment* m_env;
+    };
+
+    ui64 getSchemaHash(Type* type, Environment* env /*= nullptr*/) {
+        if (env == nullptr) env = getGlobalEnvironment();
+        BinaryHasher hasher(env);
+        hasher.add((ui32)KEG_BINARY_VERSION);
+        if (type) hasher.addType(type);
+        return hasher.getHash();
+    }
+
+    bool writeBinary(std::vector<ui8>& out, const void* src, Type* type, Environment* env /*= nullptr*/) {
+        // Test Arguments
+        if (env == nullptr) env = getGlobalEnvironment();
+        if (src == nullptr || type == nullptr) return false;
+
+        // Header, Then Every Value In Type Order
+        size_t start = out.size();
+        BinaryWriter writer(out, env);
+        writer.put((ui32)KEG_BINARY_MAGIC);
+        writer.put((ui32)KEG_BINARY_VERSION);
+        writer.put(getSchemaHash(type, env));
+        if (!writer.writeType((const ui8*)src, type)) {
+            out.resize(start);
+            return false;
+        }
+        return true;
+    }
+    bool writeBinary(std::vector<ui8>& out, const void* src, const nString& typeName, Environment* env /*= nullptr*/) {
+        // Test Arguments
+        if (env == nullptr) env = getGlobalEnvironment();
+        if (typeName.empty()) return false;
+
+        // Attempt To Find The Type
+        Type* type = env->getType(typeName);
+        if (type == nullptr) return false;
+
+        return writeBinary(out, src, type, env);
+    }
+
+    Error readBinary(void* dest, const ui8* data, size_t size, Type* type, Environment* env /*= nullptr*/) {
+        // Test Arguments
+        if (env == nullptr) env = getGlobalEnvironment();
+        if (dest == nullptr || type == nullptr || data == nullptr) {
+            return Error::BAD_ARGUMENT;
+        }
+
+        // Check The Header
+        BinaryReader reader(data, size, env);
+        ui32 magic, version;
+        ui64 hash;
+        if (!reader.get(magic) || !reader.get(version) || !reader.get(hash)) return Error::EARLY_EOF;
+        if (magic != KEG_BINARY_MAGIC) return Error::BAD_VALUE;
+        if (version != KEG_BINARY_VERSION || hash != getSchemaHash(type, env)) return Error::SCHEMA_MISMATCH;
+
+        // Parse
+        Error err = reader.readType((ui8*)dest, type);
+        if (err != Error::NONE) return err;
+        return reader.isAtEnd() ? Error::NONE : Error::BAD_VALUE;
+    }
+    Error readBinary(void* dest, const ui8* data, size_t size, const nString& typeName, Environment* env /*= nullptr*/) {
+        // Test Arguments
+        if (env == nullptr) env = getGlobalEnvironment();
+        if (typeName.empty()) return Error::BAD_ARGUMENT;
+
+        // Attempt To Find The Type
+        Type* type = env->getType(typeName);
+        if (type == nullptr) return Error::TYPE_NOT_FOUND;
+
+        return readBinary(dest, data, size, type, env);
+    }
+}
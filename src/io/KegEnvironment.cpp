@@ -5,7 +5,8 @@
 #include "Vorb/io/KegTypes.h"
 
 keg::Environment::Environment() :
-    _uuid(KEG_BAD_TYPE_ID) {
+    _uuid(KEG_BAD_TYPE_ID),
+    _frozen(false) {
     Value kv;
     Type kt;
 
@@ -95,14 +96,23 @@ keg::Environment::Environment() :
 }
 
 ui32 keg::Environment::addType(const nString& name, Type* type) {
+    if (_frozen) return KEG_BAD_TYPE_ID;
     _uuid++;
     _typesByName[name] = type;
     _typesByID[_uuid] = type;
     return _uuid;
 }
 ui32 keg::Environment::addEnum(const nString& name, Enum* type) {
+    if (_frozen) return KEG_BAD_TYPE_ID;
     _uuid++;
     _enumsByName[name] = type;
     _enumsByID[_uuid] = type;
     return _uuid;
 }
+
+keg::Environment* keg::Environment::snapshot() const {
+    // The copied dictionaries still point at this environment's basic types
+    Environment* env = new Environment(*this);
+    env->_frozen = true;
+    return env;
+}
@@ -0,0 +1,222 @@
+#include "Vorb/stdafx.h"
+#include "Vorb/io/KegPlan.h"
+
+#include <algorithm>
+
+#include "Vorb/io/YAMLImpl.h"
+
+namespace keg {
+    ui64 hashPlanKey(const char* key, size_t length) {
+        ui64 hash = 14695981039346656037ull;
+        for (size_t i = 0; i < length; i++) {
+            hash ^= (ui8)key[i];
+            hash *= 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // The Type Named By A Mapped Node's Type Field, Like getCorrectType In The YAML Reader
+    Type* getPlanNodeType(Node node, Environment* env, Type* previous) {
+        const YAML::Node& data = node->data;
+        if (!data.IsMap()) return previous;
+        const YAML::Node typeNode = data[KEG_DOC_TYPE_ID];
+        if (!typeNode || !typeNode.IsScalar()) return previous;
+        Type* otherType = env->getType(typeNode.Scalar());
+        return otherType ? otherType : previous;
+    }
+
+    // Element Or Pointed-To Type Name, Found The Same Way As The YAML Reader
+    nString getPlanInteriorTypeName(const Value* decl) {
+        if (!decl->typeName.empty() || !decl->interiorValue) return decl->typeName;
+        auto kvp = basicTypes.find(decl->interiorValue->type);
+        return (kvp != basicTypes.end()) ? kvp->second : decl->interiorValue->typeName;
+    }
+
+    void planReadNothing(ui8*, const PlanEntry&, const TypePlan&, Node, ReadContext&) {
+        // Empty
+    }
+    void planReadEvaluated(ui8* dest, const PlanEntry& entry, const TypePlan&, Node node, ReadContext&) {
+        entry.decl->evaluator(dest, node);
+    }
+    void planReadEnum(ui8* dest, const PlanEntry& entry, const TypePlan&, Node node, ReadContext&) {
+        if (node->data.IsScalar()) entry.enumType->setValue(dest, node->data.Scalar());
+        else entry.enumType->setValue(dest, keg::convert<nString>(node));
+    }
+    void planReadCustom(ui8* dest, const PlanEntry& entry, const TypePlan& plan, Node node, ReadContext& context) {
+        plan.parse(dest, node, context, entry.layout);
+    }
+    void planReadPointer(ui8* dest, const PlanEntry& entry, const TypePlan& plan, Node node, ReadContext& context) {
+        Type* type = getPlanNodeType(node, context.env, entry.type);
+        if (type == nullptr) return;
+
+        void* value = type->alloc();
+        *(void**)dest = value;
+        if (type == entry.type) {
+            plan.parse((ui8*)value, node, context, entry.layout);
+        } else {
+            // Types chosen by the document were not compiled
+            keg::parse((ui8*)value, node, context, type);
+        }
+    }
+    void planReadArray(ui8* dest, const PlanEntry& entry, const TypePlan& plan, Node node, ReadContext& context) {
+        // Either a sequence or a map holding the sequence and an optional element type
+        Type* type = entry.type;
+        const YAML::Node& map = node->data;
+        const YAML::Node dataNode = map.IsMap() ? map[KEG_DOC_DATA_ID] : YAML::Node();
+        const YAML::Node* sequence = nullptr;
+        if (map.IsSequence()) {
+            sequence = &map;
+        } else if (map.IsMap() && dataNode.IsDefined()) {
+            if (!dataNode.IsSequence()) return;
+            sequence = &dataNode;
+            const YAML::Node typeNode = map[KEG_DOC_TYPE_ID];
+            if (typeNode) type = context.env->getType(typeNode.as<nString>());
+        }
+        if (type == nullptr) return;
+
+        ArrayBase* arr = new (dest) ArrayBase(type->getSizeInBytes());
+        size_t length = sequence ? sequence->size() : 0;
+        if (length == 0) return;
+        arr->ownData(type->allocArray(length), length, type->getDeallocator());
+
+        const PlanEntry& element = plan.getEntry(entry.interior);
+        ui8* elementDest = &arr->at<ui8>(0);
+        for (auto iter = sequence->begin(); iter != sequence->end(); iter++) {
+            // Assigning to a bound YAML::Node rebinds the node it came from, so each value gets its own
+            YAMLNode value = { *iter };
+            element.reader(elementDest, element, plan, &value, context);
+            elementDest += type->getSizeInBytes();
+        }
+    }
+
+    void TypePlan::compile(Type* type, Environment* env /*= nullptr*/) {
+        m_env = env ? env : getGlobalEnvironment();
+        m_layouts.clear();
+        m_entries.clear();
+        m_layoutIndices.clear();
+        if (type) addLayout(type);
+        std::unordered_map<Type*, ui32>().swap(m_layoutIndices);
+    }
+
+    ui32 TypePlan::addLayout(Type* type) {
+        auto kvp = m_layoutIndices.find(type);
+        if (kvp != m_layoutIndices.end()) return kvp->second;
+        ui32 index = (ui32)m_layouts.size();
+        m_layoutIndices[type] = index;
+        m_layouts.push_back(Layout{ type, 0, 0 });
+
+        // Nested layouts are appended while compiling, so this layout's entries go in afterwards as one range
+        std::vector<PlanEntry> entries;
+        for (auto iter = type->getIter(); iter != type->getIterEnd(); iter++) {
+            entries.push_back(compileEntry(&iter->first, &iter->second));
+        }
+        std::sort(entries.begin(), entries.end(), [] (const PlanEntry& a, const PlanEntry& b) {
+            return a.nameHash < b.nameHash;
+        });
+        m_layouts[index].begin = (ui32)m_entries.size();
+        m_entries.insert(m_entries.end(), entries.begin(), entries.end());
+        m_layouts[index].end = (ui32)m_entries.size();
+        return index;
+    }
+
+    PlanEntry TypePlan::compileEntry(const nString* name, const Value* decl) {
+        PlanEntry entry = {};
+        entry.nameHash = name ? hashPlanKey(name->data(), name->size()) : 0;
+        entry.name = name;
+        entry.offset = decl->offset;
+        entry.reader = planReadNothing;
+        entry.decl = decl;
+        entry.layout = KEG_PLAN_NONE;
+        entry.interior = KEG_PLAN_NONE;
+
+        if (decl->evaluator) {
+            entry.reader = planReadEvaluated;
+            return entry;
+        }
+        switch (decl->type) {
+        case BasicType::ENUM:
+            entry.enumType = decl->typeName.empty() ? nullptr : m_env->getEnum(decl->typeName);
+            if (entry.enumType) entry.reader = planReadEnum;
+            break;
+        case BasicType::CUSTOM:
+            entry.type = decl->typeName.empty() ? nullptr : m_env->getType(decl->typeName);
+            if (entry.type) {
+                entry.layout = addLayout(entry.type);
+                entry.reader = planReadCustom;
+            }
+            break;
+        case BasicType::PTR: {
+            nString typeName = getPlanInteriorTypeName(decl);
+            entry.type = m_env->getType(typeName);
+            if (entry.type) entry.layout = addLayout(entry.type);
+            // Documents may name a type even if the declared one is missing
+            entry.reader = planReadPointer;
+            break;
+        }
+        case BasicType::ARRAY: {
+            nString typeName = getPlanInteriorTypeName(decl);
+            entry.type = typeName.empty() ? nullptr : m_env->getType(typeName);
+            if (decl->interiorValue) {
+                PlanEntry element = compileEntry(nullptr, decl->interiorValue.get());
+                entry.interior = (ui32)m_entries.size();
+                m_entries.push_back(element);
+                entry.reader = planReadArray;
+            }
+            break;
+        }
+        default:
+            break;
+        }
+        return entry;
+    }
+
+    const PlanEntry* TypePlan::find(ui32 layout, const char* key, size_t length) const {
+        ui64 hash = hashPlanKey(key, length);
+        const PlanEntry* begin = m_entries.data() + m_layouts[layout].begin;
+        const PlanEntry* end = m_entries.data() + m_layouts[layout].end;
+        const PlanEntry* entry = std::lower_bound(begin, end, hash, [] (const PlanEntry& e, ui64 h) {
+            return e.nameHash < h;
+        });
+        for (; entry != end && entry->nameHash == hash; entry++) {
+            if (entry->name->size() == length && memcmp(entry->name->data(), key, length) == 0) return entry;
+        }
+        return nullptr;
+    }
+
+    Error TypePlan::parse(void* dest, const cString data) const {
+        // Test Arguments
+        Type* type = getType();
+        if (dest == nullptr || type == nullptr || data == nullptr) {
+            return Error::BAD_ARGUMENT;
+        }
+
+        // Parse YAML
+        ReadContext context;
+        context.env = m_env;
+        context.reader.init(data);
+        keg::Node baseNode = context.reader.getFirst();
+        if (keg::getType(baseNode) == keg::NodeType::NONE) return Error::EARLY_EOF;
+
+        // Documents that name another type are parsed without the plan
+        Type* docType = getPlanNodeType(baseNode, m_env, type);
+        Error err = (docType == type) ? parse((ui8*)dest, baseNode, context, 0) : keg::parse((ui8*)dest, baseNode, context, docType);
+        context.reader.dispose();
+        return err;
+    }
+
+    Error TypePlan::parse(ui8* dest, Node data, ReadContext& context, ui32 layout /*= 0*/) const {
+        // Check arguments
+        if (layout >= m_layouts.size()) return Error::TYPE_NOT_FOUND;
+        if (!data->data.IsMap()) return Error::BAD_VALUE;
+
+        // Iterate Values
+        for (auto iter = data->data.begin(); iter != data->data.end(); iter++) {
+            const nString& key = iter->first.Scalar();
+            const PlanEntry* entry = find(layout, key.data(), key.size());
+            if (entry == nullptr) continue;
+            YAMLNode value = { iter->second };
+            entry->reader(dest + entry->offset, *entry, *this, &value, context);
+        }
+        return Error::NONE;
+    }
+}
@@ -0,0 +1,362 @@
+#include "Vorb/stdafx.h"
+#include "Vorb/io/Keg.h"
+
+#include <sstream>
+#include <yaml-cpp/eventhandler.h>
+
+#include "Vorb/io/KegPlan.h"
+#include "Vorb/io/YAMLImpl.h"
+
+namespace keg {
+    // Find The Pointed-To Type The Same Way The YAML Reader Does
+    Type* getStreamPointerType(const Value* decl, Environment* env) {
+        nString typeName = decl->typeName;
+        if (typeName.empty() && decl->interiorValue) {
+            auto kvp = basicTypes.find(decl->interiorValue->type);
+            if (kvp != basicTypes.end()) typeName = kvp->second;
+            else typeName = decl->interiorValue->typeName;
+        }
+        return env->getType(typeName);
+    }
+
+    // What A Mapped Type Expects From Its Next Node
+    enum class StreamState {
+        KEY,
+        VALUE,
+        TYPE_NAME
+    };
+
+    // A Type Being Filled From A Map
+    struct StreamFrame {
+    public:
+        ui8* dest; ///< Struct being filled, null until a pointer is allocated
+        Type* type; ///< Type of the struct
+        void** pointer; ///< Pointer that receives the struct once its type is known, or null
+        ui32 layout; ///< Plan layout of the type, or KEG_PLAN_NONE to look keys up in the type
+        const Value* value; ///< Value of the last key, or null to skip it
+        const PlanEntry* entry; ///< Plan entry of the last key, or null
+        StreamState state; ///< Meaning of the next node
+        bool allowTypeName; ///< True if a leading type field may change the type
+    };
+
+    // A Collection Being Built For A Value That Is Read Whole
+    struct StreamBuild {
+    public:
+        YAML::Node node;
+        YAML::Node key;
+        bool hasKey;
+    };
+
+    // Node Events, Without Their Payload
+    enum class StreamNode {
+        SCALAR,
+        NULL_VALUE,
+        ALIAS,
+        SEQUENCE,
+        MAP
+    };
+
+    // Fills Types From Parser Events
+    // Mapped types are filled key by key and unknown keys are skipped without being stored. Values that the YAML
+    // reader evaluates from a node (basic values, enums, arrays and Value::value<T>) are built into a small node
+    // and handed to evalData, so they convert exactly as keg::parse converts them. With a plan, keys are found
+    // through its layouts and values read with its entries, so no names are looked up while parsing.
+    class StreamHandler : public YAML::EventHandler {
+    public:
+        StreamHandler(ui8* dest, Type* type, Environment* env, const TypePlan* plan) :
+            m_plan(plan),
+            m_dest(dest),
+            m_type(type) {
+            m_context.env = env;
+        }
+        ~StreamHandler() {
+            m_context.reader.dispose();
+        }
+
+        void OnDocumentStart(const YAML::Mark&) override {
+            // Empty
+        }
+        void OnDocumentEnd() override {
+            // Empty
+        }
+
+        void OnNull(const YAML::Mark&, YAML::anchor_t anchor) override {
+            beginNode(StreamNode::NULL_VALUE, nullptr, anchor, nullptr);
+        }
+        void OnAlias(const YAML::Mark&, YAML::anchor_t anchor) override {
+            beginNode(StreamNode::ALIAS, nullptr, anchor, nullptr);
+        }
+        void OnScalar(const YAML::Mark&, const std::string& tag, YAML::anchor_t anchor, const std::string& value) override {
+            beginNode(StreamNode::SCALAR, &tag, anchor, &value);
+        }
+        void OnSequenceStart(const YAML::Mark&, const std::string& tag, YAML::anchor_t anchor, YAML::EmitterStyle::value) override {
+            beginNode(StreamNode::SEQUENCE, &tag, anchor, nullptr);
+        }
+        void OnSequenceEnd() override {
+            endCollection();
+        }
+        void OnMapStart(const YAML::Mark&, const std::string& tag, YAML::anchor_t anchor, YAML::EmitterStyle::value) override {
+            beginNode(StreamNode::MAP, &tag, anchor, nullptr);
+        }
+        void OnMapEnd() override {
+            endCollection();
+        }
+
+        Error getError() const {
+            return m_error;
+        }
+    private:
+        static bool isCollection(StreamNode kind) {
+            return kind == StreamNode::SEQUENCE || kind == StreamNode::MAP;
+        }
+
+        void beginNode(StreamNode kind, const std::string* tag, YAML::anchor_t anchor, const std::string* scalar) {
+            if (m_skipDepth > 0) {
+                if (isCollection(kind)) m_skipDepth++;
+                return;
+            }
+            if (!m_build.empty()) {
+                buildNode(kind, tag, anchor, scalar);
+                return;
+            }
+
+            // The document must be a map, like keg::parse expects
+            if (m_frames.empty()) {
+                if (m_rootDone) {
+                    skip(kind);
+                } else if (kind == StreamNode::MAP) {
+                    m_error = Error::NONE;
+                    m_frames.push_back(StreamFrame{ m_dest, m_type, nullptr, m_plan ? 0 : KEG_PLAN_NONE, nullptr, nullptr, StreamState::KEY, true });
+                } else {
+                    m_rootDone = true;
+                    if (kind != StreamNode::NULL_VALUE) m_error = Error::BAD_VALUE;
+                    skip(kind);
+                }
+                return;
+            }
+
+            StreamFrame& frame = m_frames.back();
+            switch (frame.state) {
+            case StreamState::KEY:
+                if (kind != StreamNode::SCALAR) {
+                    // Only scalar keys name values
+                    frame.value = nullptr;
+                    frame.entry = nullptr;
+                    frame.state = StreamState::VALUE;
+                    skip(kind);
+                } else if (frame.allowTypeName && *scalar == KEG_DOC_TYPE_ID) {
+                    frame.allowTypeName = false;
+                    frame.state = StreamState::TYPE_NAME;
+                } else {
+                    frame.allowTypeName = false;
+                    allocPointer(frame);
+                    frame.entry = nullptr;
+                    frame.value = nullptr;
+                    if (frame.dest && frame.layout != KEG_PLAN_NONE) {
+                        frame.entry = m_plan->find(frame.layout, scalar->data(), scalar->size());
+                        if (frame.entry) frame.value = frame.entry->decl;
+                    } else if (frame.dest && frame.type) {
+                        frame.value = frame.type->getValue(*scalar);
+                    }
+                    frame.state = StreamState::VALUE;
+                }
+                break;
+            case StreamState::TYPE_NAME:
+                frame.state = StreamState::KEY;
+                if (kind == StreamNode::SCALAR) {
+                    Type* other = m_context.env->getType(*scalar);
+                    if (other && other != frame.type) {
+                        // Types chosen by the document were not compiled
+                        frame.type = other;
+                        frame.layout = KEG_PLAN_NONE;
+                    }
+                } else {
+                    skip(kind);
+                }
+                break;
+            case StreamState::VALUE:
+                frame.state = StreamState::KEY;
+                beginValue(frame.dest, frame.value, frame.entry, kind, tag, anchor, scalar);
+                break;
+            }
+        }
+        void beginValue(ui8* structDest, const Value* decl, const PlanEntry* entry, StreamNode kind, const std::string* tag, YAML::anchor_t anchor, const std::string* scalar) {
+            if (decl == nullptr) {
+                skip(kind);
+                return;
+            }
+            ui8* dest = structDest + decl->offset;
+
+            // Mapped types are streamed too
+            if (!decl->evaluator) {
+                switch (decl->type) {
+                case BasicType::CUSTOM: {
+                    Type* type = entry ? entry->type : (decl->typeName.empty() ? nullptr : m_context.env->getType(decl->typeName));
+                    if (type && kind == StreamNode::MAP) {
+                        m_frames.push_back(StreamFrame{ dest, type, nullptr, entry ? entry->layout : KEG_PLAN_NONE, nullptr, nullptr, StreamState::KEY, false });
+                    } else {
+                        skip(kind);
+                    }
+                    return;
+                }
+                case BasicType::PTR: {
+                    Type* type = entry ? entry->type : getStreamPointerType(decl, m_context.env);
+                    if (kind == StreamNode::MAP) {
+                        // Allocated once a leading type field has been seen
+                        ui32 layout = (entry && type) ? entry->layout : KEG_PLAN_NONE;
+                        m_frames.push_back(StreamFrame{ nullptr, type, (void**)dest, layout, nullptr, nullptr, StreamState::KEY, true });
+                    } else {
+                        if (type) *(void**)dest = type->alloc();
+                        skip(kind);
+                    }
+                    return;
+                }
+                default:
+                    break;
+                }
+            }
+
+            // Everything else is read whole
+            m_captureDest = dest;
+            m_captureValue = decl;
+            m_captureEntry = entry;
+            buildNode(kind, tag, anchor, scalar);
+        }
+        void endCollection() {
+            if (m_skipDepth > 0) {
+                m_skipDepth--;
+                return;
+            }
+            if (!m_build.empty()) {
+                YAML::Node node = m_build.back().node;
+                m_build.pop_back();
+                if (m_build.empty()) finishCapture(node);
+                return;
+            }
+            if (!m_frames.empty()) {
+                allocPointer(m_frames.back());
+                m_frames.pop_back();
+                if (m_frames.empty()) m_rootDone = true;
+            }
+        }
+
+        void skip(StreamNode kind) {
+            if (isCollection(kind)) m_skipDepth = 1;
+        }
+        void allocPointer(StreamFrame& frame) {
+            if (frame.pointer == nullptr || frame.dest != nullptr || frame.type == nullptr) return;
+            frame.dest = (ui8*)frame.type->alloc();
+            *frame.pointer = frame.dest;
+        }
+
+        void buildNode(StreamNode kind, const std::string* tag, YAML::anchor_t anchor, const std::string* scalar) {
+            YAML::Node node;
+            switch (kind) {
+            case StreamNode::SCALAR:
+                node = YAML::Node(*scalar);
+                break;
+            case StreamNode::ALIAS: {
+                // Only anchors inside values that were read whole can be referenced
+                auto kvp = m_anchors.find(anchor);
+                node = (kvp != m_anchors.end()) ? kvp->second : YAML::Node(YAML::NodeType::Null);
+                anchor = 0;
+                break;
+            }
+            case StreamNode::SEQUENCE:
+                node = YAML::Node(YAML::NodeType::Sequence);
+                break;
+            case StreamNode::MAP:
+                node = YAML::Node(YAML::NodeType::Map);
+                break;
+            default:
+                node = YAML::Node(YAML::NodeType::Null);
+                break;
+            }
+            if (tag) node.SetTag(*tag);
+            if (anchor) m_anchors[anchor] = node;
+
+            // Collections are attached to their parent now and filled as their events arrive
+            if (!m_build.empty()) {
+                StreamBuild& parent = m_build.back();
+                if (parent.node.IsSequence()) {
+                    parent.node.push_back(node);
+                } else if (!parent.hasKey) {
+                    parent.key = node;
+                    parent.hasKey = true;
+                } else {
+                    parent.node.force_insert(parent.key, node);
+                    parent.hasKey = false;
+                }
+            }
+            if (isCollection(kind)) {
+                m_build.push_back(StreamBuild{ node, YAML::Node(), false });
+            } else if (m_build.empty()) {
+                finishCapture(node);
+            }
+        }
+        void finishCapture(const YAML::Node& data) {
+            YAMLNode value = { data };
+            keg::Node node = &value;
+            if (m_captureEntry) m_captureEntry->reader(m_captureDest, *m_captureEntry, *m_plan, node, m_context);
+            else evalData(m_captureDest, m_captureValue, node, m_context);
+            m_context.reader.dispose();
+        }
+
+        ReadContext m_context;
+        const TypePlan* m_plan;
+        ui8* m_dest;
+        Type* m_type;
+        Error m_error = Error::EARLY_EOF;
+        bool m_rootDone = false;
+        std::vector<StreamFrame> m_frames;
+        size_t m_skipDepth = 0;
+        std::vector<StreamBuild> m_build;
+        ui8* m_captureDest = nullptr;
+        const Value* m_captureValue = nullptr;
+        const PlanEntry* m_captureEntry = nullptr;
+        std::map<YAML::anchor_t, YAML::Node> m_anchors;
+    };
+
+    Error parseStream(void* dest, std::istream& data, Type* type, Environment* env /*= nullptr*/, const TypePlan* plan /*= nullptr*/) {
+        // Test Arguments
+        if (env == nullptr) env = getGlobalEnvironment();
+        if (dest == nullptr || type == nullptr) {
+            return Error::BAD_ARGUMENT;
+        }
+
+        // A plan only stands in for the type it was compiled from
+        if (plan && (plan->getType() != type || plan->getEnvironment() != env)) plan = nullptr;
+
+        // Parse The First Document
+        StreamHandler handler((ui8*)dest, type, env, plan);
+        try {
+            YAML::Parser parser(data);
+            if (!parser.HandleNextDocument(handler)) return Error::EARLY_EOF;
+        } catch (YAML::Exception&) {
+            return Error::BAD_VALUE;
+        }
+        return handler.getError();
+    }
+    Error parseStream(void* dest, std::istream& data, const nString& typeName, Environment* env /*= nullptr*/, const TypePlan* plan /*= nullptr*/) {
+        // Test Arguments
+        if (env == nullptr) env = getGlobalEnvironment();
+        if (dest == nullptr || typeName.empty()) {
+            return Error::BAD_ARGUMENT;
+        }
+
+        // Attempt To Find The Type
+        Type* type = env->getType(typeName);
+        if (type == nullptr) return Error::TYPE_NOT_FOUND;
+        return parseStream(dest, data, type, env, plan);
+    }
+    Error parseStream(void* dest, const cString data, Type* type, Environment* env /*= nullptr*/, const TypePlan* plan /*= nullptr*/) {
+        if (data == nullptr) return Error::BAD_ARGUMENT;
+        std::istringstream stream(data);
+        return parseStream(dest, stream, type, env, plan);
+    }
+    Error parseStream(void* dest, const cString data, const nString& typeName, Environment* env /*= nullptr*/, const TypePlan* plan /*= nullptr*/) {
+        if (data == nullptr) return Error::BAD_ARGUMENT;
+        std::istringstream stream(data);
+        return parseStream(dest, stream, typeName, env, plan);
+    }
+}
@@ -3,31 +3,46 @@
 
 #include "Vorb/io/YAMLImpl.h"
 
+namespace {
+    /// @return Number of nodes in a reader's block
+    size_t getBlockNodes(size_t block) {
+        return (size_t)YAML_READER_FIRST_BLOCK_NODES << block;
+    }
+}
+
 void keg::YAMLReader::init(const cString data) {
-    m_first = new YAMLNode;
-    m_allocated.insert(m_first);
+    m_first = allocNode();
     m_first->data = YAML::Load(data);
 }
 void keg::YAMLReader::dispose() {
-    for (auto node : m_allocated) delete node;
-    std::unordered_set<YAMLNode*>().swap(m_allocated);
+    // Nodes still hold references into the document, so they are destroyed before their blocks are released
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+        size_t count = (b + 1 == m_blocks.size()) ? m_blockUsed : getBlockNodes(b);
+        Node block = m_blocks[b];
+        for (size_t i = 0; i < count; i++) block[i].~YAMLNode();
+        operator delete(block);
+    }
+    std::vector<Node>().swap(m_blocks);
+    std::vector<Node>().swap(m_recycled);
+    m_blockUsed = 0;
     m_first = nullptr;
 }
 
 void keg::YAMLReader::free(Node& node) {
-    if (!node) return;
-    auto place = m_allocated.find(node);
-    if (place == m_allocated.end()) return;
-    m_allocated.erase(place);
-    delete node;
+    if (!node || !owns(node)) return;
+
+    // A node freed twice must not be handed out twice
+    if (!node->isFree) {
+        node->data.reset();
+        node->isFree = true;
+        m_recycled.push_back(node);
+    }
     node = nullptr;
 }
 
 void keg::YAMLReader::forAllInMap(Node node, Delegate<void, Sender, const nString&, Node>* f) {
     for (auto iter : node->data) {
-        Node value = new YAMLNode;
-        m_allocated.insert(value);
-
+        Node value = allocNode();
         value->data = iter.second;
         f->invoke(this, iter.first.as<nString>(), value);
     }
@@ -35,22 +50,44 @@ void keg::YAMLReader::forAllInMap(Node node, Delegate<void, Sender, const nStrin
 void keg::YAMLReader::forAllInSequence(Node node, Delegate<void, Sender, size_t, Node>* f) {
     size_t l = node->data.size();
     for (size_t i = 0; i < l; i++) {
-        Node value = new YAMLNode;
-        m_allocated.insert(value);
-
+        Node value = allocNode();
         value->data = node->data[i];
         f->invoke(this, i, value);
     }
 }
 
 CALLEE_DELETE keg::Node keg::YAMLReader::getInterior(Node node, const cString value) {
-    Node interior = new YAMLNode;
-    m_allocated.insert(interior);
-
+    Node interior = allocNode();
     interior->data = node->data[value];
     return interior;
 }
 
+keg::Node keg::YAMLReader::allocNode() {
+    // Reuse freed nodes first, they were left empty
+    if (m_recycled.size() > 0) {
+        Node node = m_recycled.back();
+        m_recycled.pop_back();
+        node->isFree = false;
+        return node;
+    }
+
+    // Start a new block once the last one is full
+    if (m_blocks.empty() || m_blockUsed == getBlockNodes(m_blocks.size() - 1)) {
+        m_blocks.push_back((Node)operator new(getBlockNodes(m_blocks.size()) * sizeof(YAMLNode)));
+        m_blockUsed = 0;
+    }
+    Node node = m_blocks.back() + m_blockUsed++;
+    new (node) YAMLNode;
+    return node;
+}
+bool keg::YAMLReader::owns(Node node) const {
+    for (size_t b = 0; b < m_blocks.size(); b++) {
+        size_t count = (b + 1 == m_blocks.size()) ? m_blockUsed : getBlockNodes(b);
+        if (node >= m_blocks[b] && node < m_blocks[b] + count) return true;
+    }
+    return false;
+}
+
 keg::NodeType keg::getType(Node node) {
     switch (node->data.Type()) {
     case YAML::NodeType::Scalar:
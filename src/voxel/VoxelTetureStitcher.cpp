@@ -1,41 +1,41 @@
 #include "Vorb/stdafx.h"
 #include "Vorb/voxel/VoxelTextureStitcher.h"
+
+#include <algorithm>
+
 #include "Vorb/ecs/BitTable.hpp"
 
 vvox::VoxelTextureStitcher::VoxelTextureStitcher(ui32 tilesPerRow /*= 16u*/) {
     m_tilesPerRow = tilesPerRow;
     m_tilesPerPage = tilesPerRow * tilesPerRow;
+    m_pageWords = (m_tilesPerPage + 63) / 64;
     // Leave space for a blank texture
     m_oldestFreeSlot = 1;
     // Always at least 1 page
     addPage();
+    markRange(m_pages[0], 0, 1);
 }
 
 vvox::VoxelTextureStitcher::~VoxelTextureStitcher() {
-    for (auto page : m_pages) delete[] page;
+    // Empty
 }
 
 ui32 vvox::VoxelTextureStitcher::mapSingle() {
-    ui32 i;
-    ui32 pageIndex;
-
-    // Find the next free slot
-    do {
-        i = m_oldestFreeSlot % m_tilesPerPage;
-        pageIndex = m_oldestFreeSlot / m_tilesPerPage;
-
-        // If we need to allocate a new page
-        if (pageIndex >= m_pages.size()) {
-            addPage();
-        }
-
-        // Since we are mapping single textures, we know this is the oldest free
-        m_oldestFreeSlot++;
-    } while (m_pages[pageIndex][i] == true);
+    // Find the next free slot, a word of the page at a time
+    ui32 pageIndex = m_oldestFreeSlot / m_tilesPerPage;
+    ui32 i = m_oldestFreeSlot % m_tilesPerPage;
+    while (true) {
+        i = findFree(getPage(pageIndex), i);
+        if (i < m_tilesPerPage) break;
+        pageIndex++;
+        i = 0;
+    }
 
     //mark this slot as not free
-    m_pages[pageIndex][i] = true;
+    markRange(m_pages[pageIndex], i, 1);
 
+    // Since we are mapping single textures, we know this is the oldest free
+    m_oldestFreeSlot = pageIndex * m_tilesPerPage + i + 1;
     return pageIndex * m_tilesPerPage + i;
 }
 
@@ -50,121 +50,192 @@ ui32 vvox::VoxelTextureStitcher::mapBox(ui32 width, ui32 height) {
 
     // Start the search at the oldest known free spot.
     ui32 searchIndex = m_oldestFreeSlot;
-    bool fits;
 
     // Find the next free slot that is large enough
     while (true) {
         i = searchIndex % m_tilesPerPage;
         pageIndex = searchIndex / m_tilesPerPage;
-        x = i % m_tilesPerRow;
-        y = i / m_tilesPerRow;
-        fits = true;
+        Page& page = getPage(pageIndex);
 
-        // If we need to allocate a new atlas
-        if (pageIndex >= m_pages.size()) {
-            addPage();
+        // Searches never start further back, so a box that did not fit in this page never will
+        bool failed = page.used + width * height > m_tilesPerPage;
+        for (size_t f = 0; f < page.boxFails.size() && !failed; f++) {
+            failed = page.boxFails[f].x <= width && page.boxFails[f].y <= height;
         }
+        if (failed) {
+            searchIndex += m_tilesPerPage - i;
+            continue;
+        }
+
+        // Jump over used slots
+        i = findFree(page, i);
+        x = i % m_tilesPerRow;
+        y = i / m_tilesPerRow;
 
         //if it doesn't fit in Y direction, go to next page
         if (y + height > m_tilesPerRow) {
-            searchIndex += m_tilesPerPage - i;
+            // Keep only the smallest boxes that failed
+            page.boxFails.erase(std::remove_if(page.boxFails.begin(), page.boxFails.end(), [&] (const ui32v2& f) {
+                return f.x >= width && f.y >= height;
+            }), page.boxFails.end());
+            page.boxFails.emplace_back(width, height);
+            searchIndex = (pageIndex + 1) * m_tilesPerPage;
             continue;
         }
         //if it doesn't fit in X direction, go to next row
         if (x + width > m_tilesPerRow) {
-            searchIndex += m_tilesPerRow - x;
+            searchIndex = pageIndex * m_tilesPerPage + (y + 1) * m_tilesPerRow;
             continue;
         }
 
-        searchIndex++;
-
-        //Search to see if all needed slots are free
+        // Find the first used slot under the box. No box starting left of it on this row can fit either.
+        ui32 blocked = m_tilesPerRow;
         for (ui32 j = y; j < y + height; j++) {
-            for (ui32 k = x; k < x + width; k++) {
-                if (m_pages[pageIndex][j * m_tilesPerRow + k] == true) {
-                    fits = false;
-                    j = y + height; //force to fall out of loop
-                    break;
-                }
+            ui32 rowStart = j * m_tilesPerRow;
+            ui32 used = findUsed(page, rowStart + x, rowStart + x + width);
+            if (used != rowStart + x + width) {
+                blocked = used - rowStart;
+                break;
             }
         }
 
-        if (fits) {
+        if (blocked == m_tilesPerRow) {
             //if we reach here, it will fit at this position
             break;
         }
+        searchIndex = pageIndex * m_tilesPerPage + y * m_tilesPerRow + blocked + 1;
     }
 
     //Set all slots to true
     for (ui32 j = y; j < y + height; j++) {
-        for (ui32 k = x; k < x + width; k++) {
-            m_pages[pageIndex][j * m_tilesPerRow + k] = true;
-        }
+        markRange(m_pages[pageIndex], j * m_tilesPerRow + x, width);
     }
 
     return i + pageIndex * m_tilesPerPage;
 }
 
 ui32 vvox::VoxelTextureStitcher::mapContiguous(ui32 numTiles) {
-
-    ui32 i;
-    ui32 pageIndex;
-    ui32 numContiguous = 0;
     // Start the search at the oldest known free spot.
     ui32 searchIndex = m_oldestFreeSlot;
     bool passedFreeSlot = false;
+    ui32 start;
 
-    // Find the next free slot that is large enough
+    // Find the next free run that is large enough
     while (true) {
-        i = searchIndex % m_tilesPerPage;
-        pageIndex = searchIndex / m_tilesPerPage;
-
-        // If we need to allocate a new atlas
-        if (pageIndex >= m_pages.size()) {
-            addPage();
+        // Skip to the next free slot
+        ui32 pageIndex = searchIndex / m_tilesPerPage;
+        ui32 i = findFree(getPage(pageIndex), searchIndex % m_tilesPerPage);
+        while (i == m_tilesPerPage) {
+            pageIndex++;
+            i = findFree(getPage(pageIndex), 0);
         }
-
-        searchIndex++;
-        if (m_pages[pageIndex][i] == true) {
-            // If we have any contiguous, then we left a free spot behind somewhere
-            if (numContiguous) {
-                passedFreeSlot = true;
+        start = pageIndex * m_tilesPerPage + i;
+
+        // Look for a used slot in the run, which may cross pages
+        ui32 end = start + numTiles;
+        ui32 blocked = end;
+        for (ui32 pos = start; pos < end;) {
+            pageIndex = pos / m_tilesPerPage;
+            ui32 pageStart = pageIndex * m_tilesPerPage;
+            ui32 limit = std::min(end - pageStart, m_tilesPerPage);
+            ui32 used = findUsed(getPage(pageIndex), pos - pageStart, limit);
+            if (used != limit) {
+                blocked = pageStart + used;
+                break;
             }
-            numContiguous = 0;
-        } else {
-            numContiguous++;
+            pos = pageStart + limit;
         }
 
         // Stop searching if we have found a contiguous block that is large enough
-        if (numContiguous == numTiles) {
-            i = searchIndex % m_tilesPerPage;
-            pageIndex = searchIndex / m_tilesPerPage;
-            break;
-        }
+        if (blocked == end) break;
+
+        // We left a free spot behind
+        passedFreeSlot = true;
+        searchIndex = blocked + 1;
     }
 
     // Move the oldest known free slot forward if we havent passed a free spot
     if (passedFreeSlot == false) {
-        m_oldestFreeSlot = i + pageIndex * m_tilesPerPage;
+        m_oldestFreeSlot = start + numTiles;
     }
 
-    ui32 index = i + pageIndex * m_tilesPerPage - numTiles;
-
     // Mark slots as full
-    for (searchIndex = index; searchIndex < index + numTiles; searchIndex++) {
-        i = searchIndex % m_tilesPerPage;
-        pageIndex = searchIndex / m_tilesPerPage;
-        m_pages[pageIndex][i] = true;
+    for (ui32 pos = start; pos < start + numTiles;) {
+        ui32 pageIndex = pos / m_tilesPerPage;
+        ui32 i = pos % m_tilesPerPage;
+        ui32 count = std::min(start + numTiles - pos, m_tilesPerPage - i);
+        markRange(m_pages[pageIndex], i, count);
+        pos += count;
     }
 
-    return index;
+    return start;
+}
+
+bool vvox::VoxelTextureStitcher::isMapped(ui32 index) const {
+    ui32 pageIndex = index / m_tilesPerPage;
+    if (pageIndex >= m_pages.size()) return false;
+    ui32 i = index % m_tilesPerPage;
+    return ((m_pages[pageIndex].bits[i >> 6] >> (i & 63)) & 1) != 0;
+}
+
+vvox::AtlasStats vvox::VoxelTextureStitcher::getStats() const {
+    AtlasStats stats;
+    stats.pages = m_pages.size();
+    stats.usedTiles = 0;
+    for (auto& page : m_pages) stats.usedTiles += page.used;
+    stats.totalTiles = stats.pages * m_tilesPerPage;
+    stats.fillRatio = stats.totalTiles ? (f32)stats.usedTiles / (f32)stats.totalTiles : 0.0f;
+    return stats;
 }
 
 void vvox::VoxelTextureStitcher::dispose() {
-    for (auto page : m_pages) delete[] page;
-    std::vector<bool*>().swap(m_pages);
+    std::vector<Page>().swap(m_pages);
 }
 
 void vvox::VoxelTextureStitcher::addPage() {
-    m_pages.push_back(new bool[m_tilesPerPage] {});
-}
\ No newline at end of file
+    m_pages.emplace_back();
+    Page& page = m_pages.back();
+    page.bits.assign(m_pageWords, 0);
+}
+
+vvox::VoxelTextureStitcher::Page& vvox::VoxelTextureStitcher::getPage(ui32 pageIndex) {
+    // If we need to allocate a new page
+    while (pageIndex >= m_pages.size()) addPage();
+    return m_pages[pageIndex];
+}
+
+void vvox::VoxelTextureStitcher::markRange(Page& page, ui32 start, ui32 count) {
+    while (count) {
+        ui32 bit = start & 63;
+        ui32 n = std::min(64 - bit, count);
+        ui64 mask = ((n == 64) ? ~0ull : ((1ull << n) - 1)) << bit;
+        ui64& word = page.bits[start >> 6];
+        page.used += vecs::impl::popcount64(mask & ~word);
+        word |= mask;
+        start += n;
+        count -= n;
+    }
+}
+
+ui32 vvox::VoxelTextureStitcher::findUsed(const Page& page, ui32 from, ui32 limit) const {
+    if (from >= limit) return limit;
+    ui32 w = from >> 6;
+    ui64 word = page.bits[w] & (~0ull << (from & 63));
+    while (true) {
+        if (word) return std::min((w << 6) + vecs::impl::lowestBit64(word), limit);
+        if (++w << 6 >= limit) return limit;
+        word = page.bits[w];
+    }
+}
+
+ui32 vvox::VoxelTextureStitcher::findFree(const Page& page, ui32 from) const {
+    if (from >= m_tilesPerPage) return m_tilesPerPage;
+    ui32 w = from >> 6;
+    ui64 word = ~page.bits[w] & (~0ull << (from & 63));
+    while (true) {
+        // Bits past the end of the page read as free, so clamp them away
+        if (word) return std::min((w << 6) + vecs::impl::lowestBit64(word), m_tilesPerPage);
+        if (++w >= m_pageWords) return m_tilesPerPage;
+        word = ~page.bits[w];
+    }
+}